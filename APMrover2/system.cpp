@@ -40,6 +40,7 @@ MENU(main_menu, THISFIRMWARE, main_menu_commands);
 
 int8_t Rover::reboot_board(uint8_t argc, const Menu::arg *argv)
 {
+    AP_Param::flush();
     hal.scheduler->reboot(false);
     return 0;
 }
@@ -232,6 +232,7 @@ void Copter::accel_cal_update()
 
 #ifdef CAL_ALWAYS_REBOOT
     if (ins.accel_cal_requires_reboot()) {
+        AP_Param::flush();
         hal.scheduler->delay(1000);
         hal.scheduler->reboot(false);
     }
@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+'''
+run Replay over a set of logs with the EKF cores updated serially and
+in parallel (EK2_THREADS/EK3_THREADS) and check that the EKF output
+messages are bit-identical
+'''
+
+import optparse, os, sys, glob, struct
+
+parser = optparse.OptionParser("CheckDeterminism")
+parser.add_option("--logdir", type='string', default='testlogs', help='directory of logs to use')
+parser.add_option("--prefixes", type='string', default='NKF,XKF', help='comma separated list of message name prefixes to compare')
+
+opts, args = parser.parse_args()
+
+HEAD1 = 0xA3
+HEAD2 = 0x95
+FMT_TYPE = 128
+
+# sizes of DataFlash format characters
+format_sizes = {
+    'b' : 1, 'B' : 1, 'h' : 2, 'H' : 2, 'i' : 4, 'I' : 4,
+    'f' : 4, 'd' : 8, 'n' : 4, 'N' : 16, 'Z' : 64,
+    'c' : 2, 'C' : 2, 'e' : 4, 'E' : 4, 'L' : 4, 'M' : 1,
+    'q' : 8, 'Q' : 8,
+}
+
+def run_cmd(cmd, dir=".", show=False, checkfail=True):
+    '''run a shell command'''
+    from subprocess import call, check_call
+    if show:
+        print("Running: '%s' in '%s'" % (cmd, dir))
+    if checkfail:
+        return check_call(cmd, shell=True, cwd=dir)
+    return call(cmd, shell=True, cwd=dir)
+
+def run_replay(logfile, threads):
+    '''run Replay on one logfile, returning the name of the log it created'''
+    log_list_current = set(glob.glob("logs/*.BIN"))
+    cmd = "./Replay.elf -- --parm EK2_THREADS=%u --parm EK3_THREADS=%u %s" % (threads, threads, logfile)
+    run_cmd(cmd, checkfail=True)
+    log_list_after = set(glob.glob("logs/*.BIN"))
+    changed = log_list_after.difference(log_list_current)
+    if len(changed) != 1:
+        print("Failed to generate log for %s" % logfile)
+        sys.exit(1)
+    return list(changed)[0]
+
+def ekf_messages(logfile, prefixes):
+    '''return a list of (name, raw bytes) for the EKF messages in a log'''
+    data = open(logfile, 'rb').read()
+    formats = { FMT_TYPE : ('FMT', 89) }
+    ret = []
+    ofs = 0
+    while ofs + 3 <= len(data):
+        if ord(data[ofs:ofs+1]) != HEAD1 or ord(data[ofs+1:ofs+2]) != HEAD2:
+            ofs += 1
+            continue
+        mtype = ord(data[ofs+2:ofs+3])
+        if mtype not in formats:
+            ofs += 1
+            continue
+        (name, length) = formats[mtype]
+        body = data[ofs:ofs+length]
+        if len(body) < length:
+            break
+        if mtype == FMT_TYPE:
+            (ftype, flen, fname, ffmt) = struct.unpack("<BB4s16s", body[3:25])
+            fname = fname.decode('ascii', 'ignore').rstrip('\0')
+            formats[ftype] = (fname, flen)
+        elif name.startswith(prefixes):
+            ret.append((name, body))
+        ofs += length
+    return ret
+
+def check_log(logfile, prefixes):
+    '''compare serial and parallel runs for one log. Return true if identical'''
+    print("Processing %s" % logfile)
+    serial_log = run_replay(logfile, 0)
+    parallel_log = run_replay(logfile, 1)
+    serial = ekf_messages(serial_log, prefixes)
+    parallel = ekf_messages(parallel_log, prefixes)
+    os.unlink(serial_log)
+    os.unlink(parallel_log)
+
+    if len(serial) == 0:
+        print("No EKF messages in %s" % logfile)
+        return False
+    for i in range(min(len(serial), len(parallel))):
+        if serial[i] != parallel[i]:
+            print("%s: message %u (%s) differs" % (logfile, i, serial[i][0]))
+            return False
+    if len(serial) != len(parallel):
+        print("%s: message count differs %u %u" % (logfile, len(serial), len(parallel)))
+        return False
+    print("%s: %u EKF messages identical" % (logfile, len(serial)))
+    return True
+
+def get_log_list():
+    '''get a list of log files to process'''
+    if os.path.isfile(opts.logdir):
+        return [opts.logdir]
+    pattern = os.path.join(opts.logdir, "*.bin")
+    file_list = glob.glob(pattern)
+    print("Found %u logs to processs" % len(file_list))
+    if len(file_list) == 0:
+        print("No logs to process matching %s" % pattern)
+        sys.exit(1)
+    return file_list
+
+prefixes = tuple(opts.prefixes.split(','))
+failures = 0
+for logfile in get_log_list():
+    if not check_log(logfile, prefixes):
+        failures += 1
+
+if failures != 0:
+    print("%u logs failed determinism check" % failures)
+    sys.exit(1)
@@ -2,36 +2,201 @@
 
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
+/*
+  wall clock time. AP_HAL::micros64() follows the log timestamps in
+  Replay so can't be used to measure throughput
+ */
+static uint64_t wall_clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000ULL + ts.tv_nsec/1000;
+}
+
+DataFlashFileReader::DataFlashFileReader()
+{
+    read_lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+}
+
+DataFlashFileReader::~DataFlashFileReader()
+{
+    if (queue != nullptr) {
+        pthread_mutex_lock(&queue_mtx);
+        parse_exit = true;
+        pthread_cond_signal(&queue_not_full);
+        pthread_mutex_unlock(&queue_mtx);
+        pthread_join(parse_thread, nullptr);
+        delete[] queue;
+    }
+    for (uint16_t i=0; i<ARRAY_SIZE(index); i++) {
+        free(index[i].offsets);
+    }
+    if (log_data != nullptr) {
+        munmap((void *)log_data, log_size);
+    }
+}
+
 bool DataFlashFileReader::open_log(const char *logfile)
 {
-    fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (log_data != nullptr || queue != nullptr) {
+        // one log per reader
+        return false;
+    }
+
+    int fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
     if (fd == -1) {
         return false;
     }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > UINT32_MAX) {
+        ::printf("Log too large (%llu bytes)\n", (unsigned long long)st.st_size);
+        ::close(fd);
+        return false;
+    }
+    log_size = st.st_size;
+    if (log_size > 0) {
+        void *p = mmap(nullptr, log_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        log_data = (const uint8_t *)p;
+        madvise(p, log_size, MADV_SEQUENTIAL);
+    }
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+
+    start_us = wall_clock_us();
+
+    return build_index();
+}
+
+/*
+  return the length of the well formed message at msg, given the
+  lengths of the formats seen so far. FMT messages update lengths
+ */
+uint8_t DataFlashFileReader::frame_length(const uint8_t *msg, uint8_t lengths[256])
+{
+    if (msg[2] == LOG_FORMAT_MSG) {
+        const struct log_Format *f = (const struct log_Format *)msg;
+        if (f->type != LOG_FORMAT_MSG) {
+            // a length too short to hold a header can't be framed
+            lengths[f->type] = f->length >= 3 ? f->length : 0;
+        }
+    }
+    return lengths[msg[2]];
+}
+
+bool DataFlashFileReader::index_add(uint8_t type, uint32_t ofs)
+{
+    if (index[type].count == index[type].allocated) {
+        uint32_t new_allocated = MAX(index[type].allocated*2, 256U);
+        uint32_t *new_offsets = (uint32_t *)realloc(index[type].offsets, new_allocated*sizeof(uint32_t));
+        if (new_offsets == nullptr) {
+            ::printf("Out of memory indexing log\n");
+            return false;
+        }
+        index[type].offsets = new_offsets;
+        index[type].allocated = new_allocated;
+    }
+    index[type].offsets[index[type].count++] = ofs;
     return true;
 }
 
-bool DataFlashFileReader::update(char type[5])
+/*
+  walk the whole log once, recording the offset of each message by
+  type and finding the end of the last complete message
+ */
+bool DataFlashFileReader::build_index(void)
 {
-    uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
-        return false;
+    uint8_t lengths[256] {};
+    lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+
+    size_t ofs = 0;
+    log_end_reason = LOG_END_EOF;
+    while (log_size - ofs >= 3) {
+        const uint8_t *p = &log_data[ofs];
+        if (p[0] != HEAD_BYTE1 || p[1] != HEAD_BYTE2) {
+            log_end_reason = LOG_END_BAD_HEADER;
+            break;
+        }
+        if (lengths[p[2]] == 0) {
+            log_end_reason = LOG_END_NO_FORMAT;
+            log_end_type = p[2];
+            break;
+        }
+        if (log_size - ofs < lengths[p[2]]) {
+            // truncated message at the end of the log
+            break;
+        }
+        if (!index_add(p[2], ofs)) {
+            return false;
+        }
+        ofs += frame_length(p, lengths);
     }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+    log_end = ofs;
+
+    return true;
+}
+
+/*
+  called when there are no more messages to process
+ */
+bool DataFlashFileReader::end_of_log(void)
+{
+    switch (log_end_reason) {
+    case LOG_END_EOF:
+        break;
+    case LOG_END_BAD_HEADER:
         printf("bad log header\n");
-        return false;
+        break;
+    case LOG_END_NO_FORMAT:
+        // can't just throw these away as the format specifies the
+        // number of bytes in the message
+        ::printf("No format defined for type (%d)\n", log_end_type);
+        exit(1);
     }
+    return false;
+}
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
-            return false;
+bool DataFlashFileReader::update(char type[5])
+{
+    uint8_t *msg;
+    uint8_t length;
+
+    if (queue != nullptr) {
+        if (!queue_pop(msg)) {
+            return end_of_log();
+        }
+        length = frame_length(msg, read_lengths);
+    } else {
+        if (read_ofs >= log_end) {
+            return end_of_log();
         }
+        // copy out of the mapping as handle_msg may modify the message
+        length = frame_length(&log_data[read_ofs], read_lengths);
+        memcpy(msgbuf, &log_data[read_ofs], length);
+        read_ofs += length;
+        msg = msgbuf;
+    }
+
+    bytes_read += length;
+    messages_read++;
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, msg, sizeof(f));
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
         strncpy(type, "FMT", 3);
         type[3] = 0;
@@ -44,23 +209,117 @@ bool DataFlashFileReader::update(char type[5])
         end_format_msgs();
     }
 
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
-        // can't just throw these away as the format specifies the
-        // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
-        exit(1);
-    }
+    const struct log_Format &f = formats[msg[2]];
 
-    uint8_t msg[f.length];
+    strncpy(type, f.name, 4);
+    type[4] = 0;
+
+    return handle_msg(f,msg);
+}
 
-    memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+bool DataFlashFileReader::start_parse_thread(void)
+{
+    if (queue != nullptr) {
+        return true;
+    }
+    queue = new uint8_t[QUEUE_SIZE][256];
+    if (queue == nullptr) {
+        return false;
+    }
+    if (pthread_create(&parse_thread, nullptr, parse_thread_main, this) != 0) {
+        delete[] queue;
+        queue = nullptr;
         return false;
     }
+    return true;
+}
+
+void *DataFlashFileReader::parse_thread_main(void *arg)
+{
+    ((DataFlashFileReader *)arg)->parse_loop();
+    return nullptr;
+}
+
+/*
+  copy messages from the log into the queue, starting where update()
+  has got to
+ */
+void DataFlashFileReader::parse_loop(void)
+{
+    uint8_t lengths[256];
+    memcpy(lengths, read_lengths, sizeof(lengths));
+    size_t ofs = read_ofs;
+    bool done = false;
+
+    while (!done) {
+        pthread_mutex_lock(&queue_mtx);
+        while (queue_count == QUEUE_SIZE && !parse_exit) {
+            pthread_cond_wait(&queue_not_full, &queue_mtx);
+        }
+        if (parse_exit) {
+            pthread_mutex_unlock(&queue_mtx);
+            return;
+        }
+        const uint16_t space = MIN(QUEUE_SIZE - queue_count, QUEUE_BATCH);
+        pthread_mutex_unlock(&queue_mtx);
+
+        // these slots are not visible to update() until queue_count
+        // is increased
+        uint16_t n = 0;
+        while (n < space && ofs < log_end) {
+            const uint8_t length = frame_length(&log_data[ofs], lengths);
+            memcpy(queue[queue_head], &log_data[ofs], length);
+            queue_head = (queue_head + 1) % QUEUE_SIZE;
+            ofs += length;
+            n++;
+        }
+        done = (ofs >= log_end);
+
+        pthread_mutex_lock(&queue_mtx);
+        queue_count += n;
+        parse_done = done;
+        pthread_cond_signal(&queue_not_empty);
+        pthread_mutex_unlock(&queue_mtx);
+    }
+}
+
+/*
+  take the next message from the queue. The slot stays owned by the
+  caller until the next call
+ */
+bool DataFlashFileReader::queue_pop(uint8_t *&msg)
+{
+    if (queue_avail == 0 || queue_consumed >= QUEUE_BATCH) {
+        pthread_mutex_lock(&queue_mtx);
+        // hand back the slots we have finished with
+        queue_count -= queue_consumed;
+        queue_consumed = 0;
+        pthread_cond_signal(&queue_not_full);
+        while (queue_count == 0 && !parse_done) {
+            pthread_cond_wait(&queue_not_empty, &queue_mtx);
+        }
+        queue_avail = queue_count;
+        pthread_mutex_unlock(&queue_mtx);
+        if (queue_avail == 0) {
+            return false;
+        }
+    }
 
-    strncpy(type, f.name, 4);
-    type[4] = 0;
+    msg = queue[queue_tail];
+    queue_tail = (queue_tail + 1) % QUEUE_SIZE;
+    queue_avail--;
+    queue_consumed++;
+    return true;
+}
 
-    return handle_msg(f,msg);
+void DataFlashFileReader::report_throughput(void) const
+{
+    const float dt = (wall_clock_us() - start_us) * 1.0e-6f;
+    if (dt <= 0) {
+        return;
+    }
+    ::printf("Read %.1f MB in %.2f seconds: %.1f MB/s, %.0f messages/s\n",
+             bytes_read / 1.0e6f, dt,
+             bytes_read / (1.0e6f * dt),
+             messages_read / dt);
 }
@@ -1,21 +1,103 @@
 #pragma once
 
+#include <pthread.h>
+
 #include <DataFlash/DataFlash.h>
 
 class DataFlashFileReader
 {
 public:
+    DataFlashFileReader();
+    virtual ~DataFlashFileReader();
+
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
+    /*
+      parse messages on a separate thread, handing them to update()
+      through a bounded queue. This keeps page faults on the log and
+      message framing off the thread running the EKF
+     */
+    bool start_parse_thread(void);
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
+    // number of messages of a type in the log, and their offsets in the file
+    uint32_t message_count(uint8_t type) const { return index[type].count; }
+    const uint32_t *message_offsets(uint8_t type) const { return index[type].offsets; }
+
+    // print read throughput since the log was opened
+    void report_throughput(void) const;
+
 protected:
-    int fd = -1;
     bool done_format_msgs = false;
     virtual void end_format_msgs(void) {}
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
+
+private:
+    // the whole log, mapped read-only
+    const uint8_t *log_data = nullptr;
+    size_t log_size = 0;
+
+    // end of the last complete, well formed message found by build_index()
+    size_t log_end = 0;
+
+    // why build_index() stopped before the end of the file
+    enum {
+        LOG_END_EOF,
+        LOG_END_BAD_HEADER,
+        LOG_END_NO_FORMAT,
+    } log_end_reason = LOG_END_EOF;
+    uint8_t log_end_type = 0;
+
+    // offset of the next message for update(), and the message
+    // lengths defined by the FMT messages it has seen
+    size_t read_ofs = 0;
+    uint8_t read_lengths[256] {};
+
+    // offsets of each message type, built once when the log is opened
+    struct {
+        uint32_t *offsets;
+        uint32_t count;
+        uint32_t allocated;
+    } index[256] {};
+
+    bool build_index(void);
+    bool index_add(uint8_t type, uint32_t ofs);
+    static uint8_t frame_length(const uint8_t *msg, uint8_t lengths[256]);
+    bool end_of_log(void);
+
+    // message being handed to handle_msg, which may modify it
+    uint8_t msgbuf[256];
+
+    /*
+      queue filled by the parse thread. Slots are handed over in
+      batches to keep lock traffic low
+     */
+    static const uint16_t QUEUE_SIZE = 4096;
+    static const uint16_t QUEUE_BATCH = 64;
+    uint8_t (*queue)[256] = nullptr;
+    uint16_t queue_count = 0;       // filled slots, protected by queue_mtx
+    bool parse_done = false;        // protected by queue_mtx
+    bool parse_exit = false;        // protected by queue_mtx
+    uint16_t queue_head = 0;        // parse thread only
+    uint16_t queue_tail = 0;        // update() only
+    uint16_t queue_avail = 0;       // slots update() may read without locking
+    uint16_t queue_consumed = 0;    // slots read but not yet returned
+    pthread_t parse_thread;
+    pthread_mutex_t queue_mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+
+    static void *parse_thread_main(void *arg);
+    void parse_loop(void);
+    bool queue_pop(uint8_t *&msg);
+
+    // throughput statistics
+    uint64_t start_us = 0;
+    uint64_t bytes_read = 0;
+    uint32_t messages_read = 0;
 };
@@ -152,7 +152,12 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	memcpy(name, f.name, 4);
 	debug("Defining log format for type (%d) (%s)\n", f.type, name);
 
+        uint8_t flags = 0;
         if (save_message_type(name)) {
+            flags |= TYPE_SAVE;
+            if (!in_list(name, nottypes)) {
+                flags |= TYPE_OUTPUT;
+            }
             /* 
                any messages which we won't be generating internally in
                replay should get the original FMT header
@@ -163,6 +168,7 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
             f_mapped.type = map_fmt_type(name, f.type);
             dataflash.WriteBlock(&f_mapped, sizeof(f_mapped));
         }
+        type_flags[f.type] = flags;
 
         if (msgparser[f.type] != NULL) {
             return true;
@@ -277,17 +283,15 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 }
 
 bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
-    char name[5];
-    memset(name, '\0', 5);
-    memcpy(name, f.name, 4);
+    const uint8_t flags = type_flags[msg[2]];
 
-    if (save_message_type(name)) {
+    if (flags & TYPE_SAVE) {
         if (mapped_msgid[msg[2]] == 0) {
             printf("Unknown msgid %u\n", (unsigned)msg[2]);
             exit(1);
         }
         msg[2] = mapped_msgid[msg[2]];
-        if (!in_list(name, nottypes)) {
+        if (flags & TYPE_OUTPUT) {
             dataflash.WriteBlock(msg, f.length);        
         }
         // a MsgHandler would probably have found a timestamp and
@@ -61,6 +61,14 @@ private:
     // mapping from original msgid to output msgid
     uint8_t mapped_msgid[256] {};
 
+    // what to do with each incoming msgid, decided once from its FMT
+    // so handle_msg() doesn't have to search the type lists
+    enum {
+        TYPE_SAVE   = (1<<0),   // not generated by replay, so copied to the output
+        TYPE_OUTPUT = (1<<1),   // saved and not in nottypes
+    };
+    uint8_t type_flags[256] {};
+
     // next available msgid for mapping
     uint8_t next_msgid = 1;
 
@@ -31,6 +31,10 @@
 #include <SITL/SITL.h>
 #endif
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
 #define streq(x, y) (!strcmp(x, y))
 
 const AP_HAL::HAL& hal = AP_HAL::get_HAL();
@@ -156,6 +160,10 @@ void Replay::usage(void)
     ::printf("\t--logmatch         match logging rate to source\n");
     ::printf("\t--no-params        don't use parameters from the log\n");
     ::printf("\t--no-fpe           do not generate floating point exceptions\n");
+    ::printf("\t--fast             parse the log on a separate thread\n");
+    ::printf("\t--sweep FILE       replay once per line of NAME=VALUE parameters in FILE\n");
+    ::printf("\t--jobs N           number of sweep replays to run at once\n");
+    ::printf("\t--ekf-summary FILE write EKF test ratio statistics to FILE\n");
 }
 
 
@@ -171,6 +179,11 @@ enum {
     OPT_NOPARAMS,
     OPT_PARAM_FILE,
     OPT_NO_FPE,
+    OPT_FAST,
+    OPT_SWEEP,
+    OPT_JOBS,
+    OPT_EKF_SUMMARY,
+    OPT_LOG_INFO,
 };
 
 void Replay::flush_dataflash(void) {
@@ -227,6 +240,11 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"logmatch",        false,  0, OPT_LOGMATCH},
         {"no-params",       false,  0, OPT_NOPARAMS},
         {"no-fpe",          false,  0, OPT_NO_FPE},
+        {"fast",            false,  0, OPT_FAST},
+        {"sweep",           true,   0, OPT_SWEEP},
+        {"jobs",            true,   0, OPT_JOBS},
+        {"ekf-summary",     true,   0, OPT_EKF_SUMMARY},
+        {"log-info",        true,   0, OPT_LOG_INFO},
         {0, false, 0, 0}
     };
 
@@ -310,6 +328,37 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             generate_fpe = false;
             break;
 
+        case OPT_FAST:
+            fast = true;
+            break;
+
+        case OPT_SWEEP:
+            load_sweep_file(gopt.optarg);
+            break;
+
+        case OPT_JOBS:
+            sweep_jobs = atoi(gopt.optarg);
+            break;
+
+        case OPT_EKF_SUMMARY:
+            ekf_summary_file = gopt.optarg;
+            break;
+
+        case OPT_LOG_INFO: {
+            // passed to sweep jobs so they don't have to rescan the log
+            unsigned rate, flags;
+            if (sscanf(gopt.optarg, "%u,%u", &rate, &flags) != 2) {
+                ::printf("Usage: --log-info RATE,FLAGS\n");
+                exit(1);
+            }
+            log_info.update_rate = rate;
+            log_info.have_imu2 = (flags & 1) != 0;
+            log_info.have_imt = (flags & 2) != 0;
+            log_info.have_imt2 = (flags & 4) != 0;
+            have_log_info = true;
+            break;
+        }
+
         case 'h':
         default:
             usage();
@@ -317,6 +366,8 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         }
     }
 
+    options_end = gopt.optind;
+
 	argv += gopt.optind;
 	argc -= gopt.optind;
 
@@ -517,7 +568,7 @@ void Replay::setup()
     // remember filename for reporting
     log_filename = filename;
 
-    if (!find_log_info(log_info)) {
+    if (!have_log_info && !find_log_info(log_info)) {
         printf("Update to get log information\n");
         exit(1);
     }
@@ -529,6 +580,16 @@ void Replay::setup()
         exit(1);
     }
 
+    if (sweep_count > 0) {
+        run_sweep(argc, argv);
+        exit(0);
+    }
+
+    if (fast && !logreader.start_parse_thread()) {
+        ::printf("Failed to start log parse thread\n");
+        exit(1);
+    }
+
     _vehicle.setup();
 
     inhibit_gyro_cal();
@@ -692,6 +753,9 @@ void Replay::read_sensors(const char *type)
         if (_vehicle.ahrs.get_home().lat != 0) {
             _vehicle.inertial_nav.update(_vehicle.ins.get_delta_time());
         }
+        if (ekf_summary_file != nullptr) {
+            update_ekf_summary();
+        }
         if ((downsample == 0 || ++output_counter % downsample == 0) && !logmatch) {
             write_ekf_logs();
         }
@@ -776,6 +840,12 @@ void Replay::flush_and_exit()
 {
     flush_dataflash();
 
+    logreader.report_throughput();
+
+    if (ekf_summary_file != nullptr) {
+        write_ekf_summary();
+    }
+
     if (check_solution) {
         report_checks();
     }
@@ -916,8 +986,263 @@ void Replay::load_param_file(const char *pfilename)
 }
 
 /*
-  see if a user parameter is set
+  load a sweep file. Each line that isn't blank or a comment is one
+  set of NAME=VALUE parameters, separated by spaces or commas
+ */
+void Replay::load_sweep_file(const char *sweep_filename)
+{
+    FILE *f = fopen(sweep_filename, "r");
+    if (f == NULL) {
+        printf("Failed to open sweep file: %s\n", sweep_filename);
+        exit(1);
+    }
+    char line[512];
+
+    while (fgets(line, sizeof(line)-1, f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        const char *p = line + strspn(line, " \t");
+        if (*p == 0 || *p == '#') {
+            continue;
+        }
+        struct sweep_job *new_sweep = (struct sweep_job *)realloc(sweep, (sweep_count+1)*sizeof(struct sweep_job));
+        if (new_sweep == NULL) {
+            printf("Out of memory loading sweep file\n");
+            exit(1);
+        }
+        sweep = new_sweep;
+        sweep[sweep_count].params = strdup(p);
+        sweep[sweep_count].pid = 0;
+        sweep[sweep_count].status = -1;
+        sweep_count++;
+    }
+    fclose(f);
+
+    if (sweep_count == 0) {
+        printf("No parameter sets in sweep file: %s\n", sweep_filename);
+        exit(1);
+    }
+}
+
+/*
+  start the replay for one set of sweep parameters as a new Replay
+  process with its own log directory. The replay HAL, parameters and
+  sensor drivers are all global so one process can only run one EKF
+  configuration
  */
+pid_t Replay::start_sweep_job(uint16_t n, uint8_t argc, char * const argv[])
+{
+    char dir[32];
+    snprintf(dir, sizeof(dir), "sweep/%03u", (unsigned)n);
+    mkdir(dir, 0777);
+
+    char summary[48];
+    snprintf(summary, sizeof(summary), "%s/summary.txt", dir);
+    char output[48];
+    snprintf(output, sizeof(output), "%s/replay.out", dir);
+    char info[32];
+    snprintf(info, sizeof(info), "%u,%u",
+             (unsigned)log_info.update_rate,
+             (unsigned)(log_info.have_imu2 | (log_info.have_imt<<1) | (log_info.have_imt2<<2)));
+
+    // build the job's arguments before forking
+    char *params = strdup(sweep[n].params);
+    const uint16_t max_args = argc + 16 + strlen(params);
+    const char **args = (const char **)calloc(max_args, sizeof(char *));
+    if (params == NULL || args == NULL) {
+        free(params);
+        free(args);
+        return -1;
+    }
+    uint16_t nargs = 0;
+    args[nargs++] = "Replay";
+    args[nargs++] = "--log-directory";
+    args[nargs++] = dir;
+    args[nargs++] = "--";
+    // our own options, apart from the sweep itself
+    for (int i=1; i<options_end && i<argc; i++) {
+        if (strcmp(argv[i], "--sweep") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            i++;
+            continue;
+        }
+        if (strncmp(argv[i], "--sweep=", 8) == 0 || strncmp(argv[i], "--jobs=", 7) == 0) {
+            continue;
+        }
+        args[nargs++] = argv[i];
+    }
+    char *saveptr = NULL;
+    for (char *p=strtok_r(params, ", \t", &saveptr); p; p=strtok_r(NULL, ", \t", &saveptr)) {
+        args[nargs++] = "--parm";
+        args[nargs++] = p;
+    }
+    args[nargs++] = "--log-info";
+    args[nargs++] = info;
+    args[nargs++] = "--ekf-summary";
+    args[nargs++] = summary;
+    args[nargs++] = filename;
+    args[nargs] = NULL;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // only async-signal-safe calls from here, we are a copy of a
+        // multi-threaded process
+        int fd = open(output, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if (fd != -1) {
+            dup2(fd, 1);
+            dup2(fd, 2);
+            close(fd);
+        }
+        execv("/proc/self/exe", (char * const *)args);
+        _exit(127);
+    }
+
+    free(params);
+    free(args);
+    return pid;
+}
+
+/*
+  replay every set of parameters in the sweep file. The log has
+  already been checked and scanned for its rate, which is passed to
+  each job along with the parameters
+ */
+void Replay::run_sweep(uint8_t argc, char * const argv[])
+{
+    if (sweep_jobs == 0) {
+        long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+        sweep_jobs = ncpus > 0 ? ncpus : 1;
+    }
+    mkdir("sweep", 0777);
+
+    ::printf("Sweeping %u parameter sets, %u at a time\n",
+             (unsigned)sweep_count, (unsigned)sweep_jobs);
+
+    uint16_t next = 0;
+    uint16_t running = 0;
+    uint16_t done = 0;
+    while (done < sweep_count) {
+        while (running < sweep_jobs && next < sweep_count) {
+            sweep[next].pid = start_sweep_job(next, argc, argv);
+            if (sweep[next].pid == -1) {
+                ::printf("Failed to start sweep job %u\n", (unsigned)next);
+                done++;
+            } else {
+                running++;
+            }
+            next++;
+        }
+        if (running == 0) {
+            continue;
+        }
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (uint16_t i=0; i<next; i++) {
+            if (sweep[i].pid == pid) {
+                sweep[i].status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                ::printf("Sweep job %u finished (%s): %s\n",
+                         (unsigned)i,
+                         sweep[i].status == 0 ? "ok" : "failed",
+                         sweep[i].params);
+                running--;
+                done++;
+                break;
+            }
+        }
+    }
+
+    report_sweep();
+}
+
+/*
+  gather the EKF summaries of the sweep jobs into one table
+ */
+void Replay::report_sweep(void)
+{
+    FILE *f = xfopen("sweep/results.txt", "w");
+    bool have_header = false;
+
+    for (uint16_t i=0; i<sweep_count; i++) {
+        char path[48];
+        snprintf(path, sizeof(path), "sweep/%03u/summary.txt", (unsigned)i);
+        char header[256] {};
+        char values[256] {};
+        FILE *sf = fopen(path, "r");
+        if (sf != NULL) {
+            if (fgets(header, sizeof(header), sf) == NULL ||
+                fgets(values, sizeof(values), sf) == NULL) {
+                values[0] = 0;
+            }
+            fclose(sf);
+        }
+        header[strcspn(header, "\n")] = 0;
+        values[strcspn(values, "\n")] = 0;
+        if (!have_header && header[0] != 0) {
+            fprintf(f, "Job\tStatus\t%s\tParams\n", header);
+            have_header = true;
+        }
+        fprintf(f, "%03u\t%d\t%s\t%s\n",
+                (unsigned)i, sweep[i].status,
+                values[0] ? values : "-", sweep[i].params);
+    }
+    fclose(f);
+
+    ::printf("Sweep results in sweep/results.txt\n");
+}
+
+/*
+  accumulate the innovation test ratios of the active EKF
+ */
+void Replay::update_ekf_summary(void)
+{
+    float velVar, posVar, hgtVar, tasVar;
+    Vector3f magVar;
+    Vector2f offset;
+    if (!_vehicle.ahrs.get_variances(velVar, posVar, hgtVar, magVar, tasVar, offset)) {
+        return;
+    }
+    ekf_summary.count++;
+    ekf_summary.vel.update(velVar);
+    ekf_summary.pos.update(posVar);
+    ekf_summary.hgt.update(hgtVar);
+    ekf_summary.mag.update(magVar.length());
+    ekf_summary.tas.update(tasVar);
+}
+
+/*
+  write the test ratio statistics as a header line and a value line
+ */
+void Replay::write_ekf_summary(void)
+{
+    FILE *f = xfopen(ekf_summary_file, "w");
+    const float n = MAX(ekf_summary.count, 1U);
+    const struct {
+        const char *name;
+        const test_ratio &r;
+    } ratios[] = {
+        { "Vel", ekf_summary.vel },
+        { "Pos", ekf_summary.pos },
+        { "Hgt", ekf_summary.hgt },
+        { "Mag", ekf_summary.mag },
+        { "Tas", ekf_summary.tas },
+    };
+    fprintf(f, "Samples");
+    for (uint8_t i=0; i<ARRAY_SIZE(ratios); i++) {
+        fprintf(f, "\t%sMean\t%sMax\t%sFail", ratios[i].name, ratios[i].name, ratios[i].name);
+    }
+    fprintf(f, "\n%u", (unsigned)ekf_summary.count);
+    for (uint8_t i=0; i<ARRAY_SIZE(ratios); i++) {
+        fprintf(f, "\t%.3f\t%.3f\t%u",
+                ratios[i].r.sum / n, ratios[i].r.max, (unsigned)ratios[i].r.fails);
+    }
+    fprintf(f, "\n");
+    fclose(f);
+}
+
 bool Replay::check_user_param(const char *name)
 {
     for (struct user_parameter *u=user_parameters; u; u=u->next) {
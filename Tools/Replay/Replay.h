@@ -50,6 +50,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <unistd.h>
+#include <sys/types.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 
 class ReplayVehicle {
@@ -106,6 +107,8 @@ public:
         bool have_imt:1;
         bool have_imt2:1;
     } log_info {};
+    // true if log_info was passed on the command line by a sweep
+    bool have_log_info = false;
 
     // return true if a user parameter of name is set
     bool check_user_param(const char *name);
@@ -140,6 +143,8 @@ private:
     const char **nottypes = NULL;
     uint16_t downsample = 0;
     bool logmatch = false;
+    bool fast = false;
+    int options_end = 0;
     uint32_t output_counter = 0;
     uint64_t last_timestamp = 0;
 
@@ -152,6 +157,38 @@ private:
         float max_vel_error;
     } check_result {};
 
+    /*
+      parameter sweep. Each set of parameters is replayed in its own
+      process, up to sweep_jobs at once
+     */
+    struct sweep_job {
+        char *params;           // NAME=VALUE list from the sweep file
+        pid_t pid;
+        int status;
+    } *sweep = nullptr;
+    uint16_t sweep_count = 0;
+    uint16_t sweep_jobs = 0;
+
+    // statistics of the EKF innovation test ratios, written to
+    // ekf_summary_file at exit
+    const char *ekf_summary_file = nullptr;
+    struct test_ratio {
+        float sum;
+        float max;
+        uint32_t fails;         // samples over 1, which the EKF rejects
+        void update(float v) {
+            sum += v;
+            max = MAX(max, v);
+            if (v > 1) {
+                fails++;
+            }
+        }
+    };
+    struct {
+        uint32_t count;
+        test_ratio vel, pos, hgt, mag, tas;
+    } ekf_summary {};
+
     void _parse_command_line(uint8_t argc, char * const argv[]);
 
     struct user_parameter {
@@ -177,6 +214,12 @@ private:
     void load_param_file(const char *filename);
     void set_signal_handlers(void);
     void flush_and_exit();
+    void load_sweep_file(const char *sweep_filename);
+    void run_sweep(uint8_t argc, char * const argv[]);
+    pid_t start_sweep_job(uint16_t n, uint8_t argc, char * const argv[]);
+    void report_sweep(void);
+    void update_ekf_summary(void);
+    void write_ekf_summary(void);
 
     FILE *xfopen(const char *f, const char *mode);
 };
@@ -0,0 +1,113 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+  throughput of ByteBuffer and SPSCByteBuffer moving 1MB per iteration
+  in chunks of state.range_x() bytes, with the producer and consumer on
+  one thread, on two threads sharing a CPU and on two threads on
+  different CPUs
+ */
+
+#define BUFFER_SIZE 16384
+#define TRANSFER_SIZE (1024*1024)
+
+enum Placement {
+    SINGLE_THREAD,
+    SAME_CPU,
+    CROSS_CPU,
+};
+
+static void pin_to_cpu(pthread_t thread, unsigned cpu)
+{
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu % sysconf(_SC_NPROCESSORS_ONLN), &cpuset);
+    pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
+}
+
+template <class Buffer>
+struct Transfer {
+    Buffer buf{BUFFER_SIZE};
+    uint32_t chunk;
+
+    static void *producer_main(void *arg)
+    {
+        Transfer *t = (Transfer *)arg;
+        uint8_t data[BUFFER_SIZE] {};
+        uint32_t remaining = TRANSFER_SIZE;
+        while (remaining > 0) {
+            uint32_t n = t->buf.write(data, remaining < t->chunk ? remaining : t->chunk);
+            if (n == 0) {
+                sched_yield();
+            }
+            remaining -= n;
+        }
+        return nullptr;
+    }
+
+    void consume(void)
+    {
+        uint8_t data[BUFFER_SIZE];
+        uint32_t remaining = TRANSFER_SIZE;
+        while (remaining > 0) {
+            uint32_t n = buf.read(data, chunk);
+            if (n == 0) {
+                sched_yield();
+            }
+            remaining -= n;
+        }
+        gbenchmark_escape(data);
+    }
+};
+
+template <class Buffer>
+static void BM_Transfer(benchmark::State& state, Placement placement)
+{
+    Transfer<Buffer> t;
+    t.chunk = state.range_x();
+
+    if (placement != SINGLE_THREAD) {
+        pin_to_cpu(pthread_self(), 0);
+    }
+
+    uint8_t data[BUFFER_SIZE] {};
+    while (state.KeepRunning()) {
+        if (placement == SINGLE_THREAD) {
+            for (uint32_t ofs = 0; ofs < TRANSFER_SIZE; ofs += t.chunk) {
+                t.buf.write(data, t.chunk);
+                t.buf.read(data, t.chunk);
+            }
+            gbenchmark_escape(data);
+            continue;
+        }
+        pthread_t producer;
+        pthread_create(&producer, nullptr, Transfer<Buffer>::producer_main, &t);
+        pin_to_cpu(producer, placement == SAME_CPU ? 0 : 1);
+        t.consume();
+        pthread_join(producer, nullptr);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * TRANSFER_SIZE);
+}
+
+static void BM_ByteBufferSingle(benchmark::State& state) { BM_Transfer<ByteBuffer>(state, SINGLE_THREAD); }
+static void BM_SPSCByteBufferSingle(benchmark::State& state) { BM_Transfer<SPSCByteBuffer>(state, SINGLE_THREAD); }
+static void BM_ByteBufferSameCPU(benchmark::State& state) { BM_Transfer<ByteBuffer>(state, SAME_CPU); }
+static void BM_SPSCByteBufferSameCPU(benchmark::State& state) { BM_Transfer<SPSCByteBuffer>(state, SAME_CPU); }
+static void BM_ByteBufferCrossCPU(benchmark::State& state) { BM_Transfer<ByteBuffer>(state, CROSS_CPU); }
+static void BM_SPSCByteBufferCrossCPU(benchmark::State& state) { BM_Transfer<SPSCByteBuffer>(state, CROSS_CPU); }
+
+BENCHMARK(BM_ByteBufferSingle)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_SPSCByteBufferSingle)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_ByteBufferSameCPU)->Arg(64)->Arg(1024);
+BENCHMARK(BM_SPSCByteBufferSameCPU)->Arg(64)->Arg(1024);
+BENCHMARK(BM_ByteBufferCrossCPU)->Arg(64)->Arg(1024);
+BENCHMARK(BM_SPSCByteBufferCrossCPU)->Arg(64)->Arg(1024);
+
+BENCHMARK_MAIN()
@@ -250,3 +250,257 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     }
     return buf[(head+ofs)%size];
 }
+
+/*
+ * SPSCByteBuffer
+ *
+ * Each side loads its own index relaxed, as only it writes it, and the
+ * other side's index with acquire so the data written before it was
+ * published is visible. Indexes are published with release.
+ */
+static uint32_t round_up_pow2(uint32_t n)
+{
+    if (n <= 1) {
+        return n;
+    }
+    n--;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+    return n + 1;
+}
+
+SPSCByteBuffer::SPSCByteBuffer(uint32_t _size)
+{
+    _size = round_up_pow2(_size);
+    buf = _size ? (uint8_t*)malloc(_size) : nullptr;
+    size = buf ? _size : 0;
+    mask = size ? size - 1 : 0;
+}
+
+SPSCByteBuffer::~SPSCByteBuffer(void)
+{
+    free(buf);
+}
+
+/*
+ * Caller is responsible for locking in set_size()
+ */
+bool SPSCByteBuffer::set_size(uint32_t _size)
+{
+    clear();
+    _size = round_up_pow2(_size);
+    if (_size != size) {
+        free(buf);
+        buf = nullptr;
+        size = 0;
+        mask = 0;
+        if (_size == 0) {
+            return true;
+        }
+        buf = (uint8_t*)malloc(_size);
+        if (!buf) {
+            return false;
+        }
+        size = _size;
+        mask = size - 1;
+    }
+
+    return true;
+}
+
+void SPSCByteBuffer::clear(void)
+{
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    cached_head = 0;
+    cached_tail = 0;
+}
+
+uint32_t SPSCByteBuffer::available(void) const
+{
+    // head first: tail can only move further ahead of it. A caller
+    // that is neither side may see the producer refill in between
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t n = _tail - _head;
+    return n > size ? size : n;
+}
+
+uint32_t SPSCByteBuffer::space(void) const
+{
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t used = _tail - _head;
+    // the consumer may have advanced past our copy of tail
+    return used > size ? size : size - used;
+}
+
+bool SPSCByteBuffer::empty(void) const
+{
+    return available() == 0;
+}
+
+uint32_t SPSCByteBuffer::consumer_available(uint32_t want)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    uint32_t n = cached_tail - _head;
+    if (n < want) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        n = cached_tail - _head;
+    }
+    return n;
+}
+
+uint32_t SPSCByteBuffer::producer_space(uint32_t want)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    uint32_t n = size - (_tail - cached_head);
+    if (n < want) {
+        cached_head = head.load(std::memory_order_acquire);
+        n = size - (_tail - cached_head);
+    }
+    return n;
+}
+
+uint8_t SPSCByteBuffer::reserve(IoVec iovec[2], uint32_t len)
+{
+    const uint32_t n = producer_space(len);
+    if (len > n) {
+        len = n;
+    }
+    if (!len) {
+        return 0;
+    }
+
+    const uint32_t ofs = tail.load(std::memory_order_relaxed) & mask;
+    iovec[0].data = &buf[ofs];
+
+    const uint32_t contiguous = size - ofs;
+    if (len <= contiguous) {
+        iovec[0].len = len;
+        return 1;
+    }
+
+    iovec[0].len = contiguous;
+    iovec[1].data = buf;
+    iovec[1].len = len - contiguous;
+
+    return 2;
+}
+
+bool SPSCByteBuffer::commit(uint32_t len)
+{
+    if (len > producer_space(len)) {
+        return false;
+    }
+    tail.store(tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    return true;
+}
+
+uint32_t SPSCByteBuffer::write(const uint8_t *data, uint32_t len)
+{
+    IoVec vec[2];
+    const auto n_vec = reserve(vec, len);
+    uint32_t ret = 0;
+
+    for (int i = 0; i < n_vec; i++) {
+        memcpy(vec[i].data, data + ret, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    commit(ret);
+    return ret;
+}
+
+const uint8_t *SPSCByteBuffer::readptr(uint32_t &available_bytes)
+{
+    const uint32_t n = consumer_available(1);
+    const uint32_t ofs = head.load(std::memory_order_relaxed) & mask;
+    const uint32_t contiguous = size - ofs;
+    available_bytes = n < contiguous ? n : contiguous;
+
+    return available_bytes ? &buf[ofs] : nullptr;
+}
+
+uint8_t SPSCByteBuffer::peekiovec(IoVec iovec[2], uint32_t len)
+{
+    const uint32_t n = consumer_available(len);
+    if (len > n) {
+        len = n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    const uint32_t ofs = head.load(std::memory_order_relaxed) & mask;
+    iovec[0].data = &buf[ofs];
+
+    const uint32_t contiguous = size - ofs;
+    if (len <= contiguous) {
+        iovec[0].len = len;
+        return 1;
+    }
+
+    iovec[0].len = contiguous;
+    iovec[1].data = buf;
+    iovec[1].len = len - contiguous;
+
+    return 2;
+}
+
+uint32_t SPSCByteBuffer::peekbytes(uint8_t *data, uint32_t len)
+{
+    IoVec vec[2];
+    const auto n_vec = peekiovec(vec, len);
+    uint32_t ret = 0;
+
+    for (int i = 0; i < n_vec; i++) {
+        memcpy(data + ret, vec[i].data, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    return ret;
+}
+
+bool SPSCByteBuffer::advance(uint32_t n)
+{
+    if (n > consumer_available(n)) {
+        return false;
+    }
+    head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    return true;
+}
+
+uint32_t SPSCByteBuffer::read(uint8_t *data, uint32_t len)
+{
+    uint32_t ret = peekbytes(data, len);
+    advance(ret);
+    return ret;
+}
+
+bool SPSCByteBuffer::read_byte(uint8_t *data)
+{
+    if (!data) {
+        return false;
+    }
+    if (consumer_available(1) == 0) {
+        return false;
+    }
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    *data = buf[_head & mask];
+    head.store(_head + 1, std::memory_order_release);
+    return true;
+}
+
+int16_t SPSCByteBuffer::peek(uint32_t ofs) const
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    if (ofs >= _tail - _head) {
+        return -1;
+    }
+    return buf[(_head + ofs) & mask];
+}
@@ -91,6 +91,103 @@ private:
     std::atomic<uint32_t> tail{0}; // where to write data
 };
 
+// used to keep data written by different threads on separate cache lines
+#ifndef AP_HAL_CACHE_LINE_SIZE
+#define AP_HAL_CACHE_LINE_SIZE 64
+#endif
+
+/*
+ * Circular buffer of bytes for exactly one producer thread and one
+ * consumer thread.
+ *
+ * write(), reserve() and commit() may only be called by the producer
+ * and read(), read_byte(), readptr(), peek*() and advance() only by the
+ * consumer. available(), space() and empty() may be called by
+ * either. clear() and set_size() need external locking, as with
+ * ByteBuffer.
+ *
+ * The size is rounded up to a power of two and all of it can be
+ * used. The read and write indexes are kept on separate cache lines,
+ * each with the owning thread's last seen copy of the other index, so
+ * the opposite line is only read when the cached copy says the buffer
+ * is empty or full.
+ */
+class SPSCByteBuffer {
+public:
+    typedef ByteBuffer::IoVec IoVec;
+
+    SPSCByteBuffer(uint32_t size);
+    ~SPSCByteBuffer(void);
+
+    // number of bytes available to be read
+    uint32_t available(void) const;
+
+    // Discards the buffer content, emptying it.
+    void clear(void);
+
+    // number of bytes space available to write
+    uint32_t space(void) const;
+
+    // true if available() is zero
+    bool empty(void) const;
+
+    // write bytes to ringbuffer. Returns number of bytes written
+    uint32_t write(const uint8_t *data, uint32_t len);
+
+    // read bytes from ringbuffer. Returns number of bytes read
+    uint32_t read(uint8_t *data, uint32_t len);
+
+    // read a byte from ring buffer. Returns true on success, false otherwise
+    bool read_byte(uint8_t *data);
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const { return size; }
+
+    // set size of ringbuffer, caller responsible for locking
+    bool set_size(uint32_t size);
+
+    // advance the read pointer (discarding bytes)
+    bool advance(uint32_t n);
+
+    // Returns the pointer and size to a contiguous read of the next available data
+    const uint8_t *readptr(uint32_t &available_bytes);
+
+    // peek one byte without advancing read pointer. Return byte
+    // or -1 if none available
+    int16_t peek(uint32_t ofs) const;
+
+    // read len bytes without advancing the read pointer
+    uint32_t peekbytes(uint8_t *data, uint32_t len);
+
+    // fill vec with up to len readable bytes, see ByteBuffer::peekiovec()
+    uint8_t peekiovec(IoVec vec[2], uint32_t len);
+
+    // reserve up to len bytes for writing, see ByteBuffer::reserve()
+    uint8_t reserve(IoVec vec[2], uint32_t len);
+
+    // make len reserved bytes available to the consumer
+    bool commit(uint32_t len);
+
+private:
+    // bytes readable by the consumer, refreshing its copy of tail if needed
+    uint32_t consumer_available(uint32_t want);
+    // bytes writable by the producer, refreshing its copy of head if needed
+    uint32_t producer_space(uint32_t want);
+
+    // not changed while the buffer is in use
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t mask;
+
+    // consumer owned. head and tail are free running, masked on access
+    alignas(AP_HAL_CACHE_LINE_SIZE) std::atomic<uint32_t> head{0};
+    uint32_t cached_tail = 0;
+
+    // producer owned
+    alignas(AP_HAL_CACHE_LINE_SIZE) std::atomic<uint32_t> tail{0};
+    uint32_t cached_head = 0;
+};
+
 /*
   ring buffer class for objects of fixed size
  */
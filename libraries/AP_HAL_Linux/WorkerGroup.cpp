@@ -0,0 +1,143 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "WorkerGroup.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <AP_HAL/AP_HAL.h>
+
+extern const AP_HAL::HAL &hal;
+
+namespace Linux {
+
+WorkerGroup::~WorkerGroup()
+{
+    if (_workers == nullptr) {
+        return;
+    }
+
+    pthread_mutex_lock(&_mtx);
+    _exiting = true;
+    pthread_cond_broadcast(&_start_cond);
+    pthread_mutex_unlock(&_mtx);
+
+    for (uint8_t i = 1; i < _num_jobs; i++) {
+        _workers[i].join();
+    }
+    delete[] _workers;
+}
+
+bool WorkerGroup::start(const char *name, uint8_t num_jobs, int prio, uint8_t first_cpu)
+{
+    if (_workers != nullptr || num_jobs == 0 || num_jobs > MAX_JOBS) {
+        return false;
+    }
+
+    _workers = new Worker[num_jobs];
+    if (_workers == nullptr) {
+        return false;
+    }
+    _num_jobs = num_jobs;
+
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpus < 1) {
+        ncpus = 1;
+    }
+
+    // worker 0 is never started, its job runs on the caller's thread
+    for (uint8_t i = 1; i < num_jobs; i++) {
+        char thread_name[16];
+        snprintf(thread_name, sizeof(thread_name), "%s%u", name, (unsigned)i);
+
+        _workers[i].group = this;
+        _workers[i].index = i;
+        if (!_workers[i].start(thread_name, SCHED_FIFO, prio)) {
+            return false;
+        }
+
+        if (!_workers[i].set_cpu((first_cpu + i - 1) % ncpus)) {
+            hal.console->printf("WorkerGroup: failed to pin %s\n", thread_name);
+        }
+    }
+
+    return true;
+}
+
+void WorkerGroup::run()
+{
+    if (_num_jobs > 1) {
+        pthread_mutex_lock(&_mtx);
+        _pending = _num_jobs - 1;
+        _generation++;
+        pthread_cond_broadcast(&_start_cond);
+        pthread_mutex_unlock(&_mtx);
+    }
+
+    _job(0);
+
+    if (_num_jobs > 1) {
+        pthread_mutex_lock(&_mtx);
+        while (_pending > 0) {
+            pthread_cond_wait(&_done_cond, &_mtx);
+        }
+        pthread_mutex_unlock(&_mtx);
+    }
+}
+
+void WorkerGroup::_worker_loop(uint8_t index)
+{
+    uint32_t last_generation = 0;
+
+    while (true) {
+        pthread_mutex_lock(&_mtx);
+        while (_generation == last_generation && !_exiting) {
+            pthread_cond_wait(&_start_cond, &_mtx);
+        }
+        if (_exiting) {
+            pthread_mutex_unlock(&_mtx);
+            return;
+        }
+        last_generation = _generation;
+        pthread_mutex_unlock(&_mtx);
+
+        _job(index);
+
+        pthread_mutex_lock(&_mtx);
+        if (--_pending == 0) {
+            pthread_cond_signal(&_done_cond);
+        }
+        pthread_mutex_unlock(&_mtx);
+    }
+}
+
+bool WorkerGroup::Worker::set_cpu(unsigned cpu)
+{
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+
+    return pthread_setaffinity_np(_ctx, sizeof(cpuset), &cpuset) == 0;
+}
+
+bool WorkerGroup::Worker::_run()
+{
+    group->_worker_loop(index);
+    return true;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <pthread.h>
+#include <inttypes.h>
+
+#include <AP_HAL/utility/functor.h>
+
+#include "Thread.h"
+
+namespace Linux {
+
+/*
+ * Run a fixed number of jobs in parallel and wait for all of them to
+ * finish. Job 0 runs on the calling thread, every other job has its own
+ * worker thread pinned to a CPU. run() is a barrier: when it returns all
+ * jobs have completed and their results are visible to the caller.
+ */
+class WorkerGroup {
+public:
+    FUNCTOR_TYPEDEF(job_t, void, uint8_t);
+
+    static const uint8_t MAX_JOBS = 8;
+
+    WorkerGroup(job_t job) : _job(job) { }
+
+    ~WorkerGroup();
+
+    /*
+     * Create the worker threads for jobs 1..num_jobs-1 using SCHED_FIFO
+     * with the given priority. Worker threads are pinned to CPUs starting
+     * at first_cpu, wrapping around the number of online CPUs.
+     */
+    bool start(const char *name, uint8_t num_jobs, int prio, uint8_t first_cpu = 1);
+
+    // run all jobs once and wait for them to finish
+    void run();
+
+    uint8_t num_jobs() const { return _num_jobs; }
+
+private:
+    class Worker : public Thread {
+    public:
+        Worker() : Thread(nullptr) { }
+
+        WorkerGroup *group = nullptr;
+        uint8_t index = 0;
+
+        bool set_cpu(unsigned cpu);
+
+    protected:
+        bool _run() override;
+    };
+
+    void _worker_loop(uint8_t index);
+
+    job_t _job;
+    uint8_t _num_jobs = 1;
+    Worker *_workers = nullptr;
+
+    pthread_mutex_t _mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t _start_cond = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t _done_cond = PTHREAD_COND_INITIALIZER;
+
+    // incremented by run() to release the workers for one pass
+    uint32_t _generation = 0;
+    // number of workers that have not finished the current pass
+    uint8_t _pending = 0;
+    bool _exiting = false;
+};
+
+}
@@ -0,0 +1,108 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  portable 4-wide float vector abstraction
+
+  Maps onto SSE on x86 and NEON on ARM, with a plain scalar
+  implementation for everything else (including the microcontroller
+  boards). Code written against these helpers produces the same
+  results on every target to within float rounding.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define AP_MATH_HAVE_SIMD 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AP_MATH_HAVE_SIMD 1
+#else
+#define AP_MATH_HAVE_SIMD 0
+#endif
+
+// number of floats in a simd_float4
+#define SIMD_FLOAT4_WIDTH 4
+
+// alignment required by simd_load()/simd_store()
+#define SIMD_ALIGN 16
+
+#if defined(__SSE__)
+
+typedef __m128 simd_float4;
+
+static inline simd_float4 simd_zero() { return _mm_setzero_ps(); }
+static inline simd_float4 simd_set1(float v) { return _mm_set1_ps(v); }
+static inline simd_float4 simd_load(const float *p) { return _mm_load_ps(p); }
+static inline simd_float4 simd_loadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void simd_store(float *p, simd_float4 a) { _mm_store_ps(p, a); }
+static inline void simd_storeu(float *p, simd_float4 a) { _mm_storeu_ps(p, a); }
+static inline simd_float4 simd_add(simd_float4 a, simd_float4 b) { return _mm_add_ps(a, b); }
+static inline simd_float4 simd_sub(simd_float4 a, simd_float4 b) { return _mm_sub_ps(a, b); }
+static inline simd_float4 simd_mul(simd_float4 a, simd_float4 b) { return _mm_mul_ps(a, b); }
+// a + b*c
+static inline simd_float4 simd_madd(simd_float4 a, simd_float4 b, simd_float4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+typedef float32x4_t simd_float4;
+
+static inline simd_float4 simd_zero() { return vdupq_n_f32(0.0f); }
+static inline simd_float4 simd_set1(float v) { return vdupq_n_f32(v); }
+static inline simd_float4 simd_load(const float *p) { return vld1q_f32(p); }
+static inline simd_float4 simd_loadu(const float *p) { return vld1q_f32(p); }
+static inline void simd_store(float *p, simd_float4 a) { vst1q_f32(p, a); }
+static inline void simd_storeu(float *p, simd_float4 a) { vst1q_f32(p, a); }
+static inline simd_float4 simd_add(simd_float4 a, simd_float4 b) { return vaddq_f32(a, b); }
+static inline simd_float4 simd_sub(simd_float4 a, simd_float4 b) { return vsubq_f32(a, b); }
+static inline simd_float4 simd_mul(simd_float4 a, simd_float4 b) { return vmulq_f32(a, b); }
+// a + b*c
+static inline simd_float4 simd_madd(simd_float4 a, simd_float4 b, simd_float4 c) { return vmlaq_f32(a, b, c); }
+
+#else
+
+struct simd_float4 {
+    float v[SIMD_FLOAT4_WIDTH];
+};
+
+static inline simd_float4 simd_set1(float v) { return simd_float4{{v, v, v, v}}; }
+static inline simd_float4 simd_zero() { return simd_set1(0.0f); }
+static inline simd_float4 simd_loadu(const float *p) { return simd_float4{{p[0], p[1], p[2], p[3]}}; }
+static inline simd_float4 simd_load(const float *p) { return simd_loadu(p); }
+static inline void simd_storeu(float *p, simd_float4 a)
+{
+    for (uint8_t i=0; i<SIMD_FLOAT4_WIDTH; i++) {
+        p[i] = a.v[i];
+    }
+}
+static inline void simd_store(float *p, simd_float4 a) { simd_storeu(p, a); }
+static inline simd_float4 simd_add(simd_float4 a, simd_float4 b)
+{
+    return simd_float4{{a.v[0]+b.v[0], a.v[1]+b.v[1], a.v[2]+b.v[2], a.v[3]+b.v[3]}};
+}
+static inline simd_float4 simd_sub(simd_float4 a, simd_float4 b)
+{
+    return simd_float4{{a.v[0]-b.v[0], a.v[1]-b.v[1], a.v[2]-b.v[2], a.v[3]-b.v[3]}};
+}
+static inline simd_float4 simd_mul(simd_float4 a, simd_float4 b)
+{
+    return simd_float4{{a.v[0]*b.v[0], a.v[1]*b.v[1], a.v[2]*b.v[2], a.v[3]*b.v[3]}};
+}
+// a + b*c
+static inline simd_float4 simd_madd(simd_float4 a, simd_float4 b, simd_float4 c) { return simd_add(a, simd_mul(b, c)); }
+
+#endif
@@ -6,6 +6,12 @@
 #include <GCS_MAVLink/GCS.h>
 #include <DataFlash/DataFlash.h>
 
+// run the core worker threads at the same priority as the Linux main loop
+#define EK2_WORKER_PRIORITY 12
+
+static const char *perf_core_names[] = { "EK2_Core0", "EK2_Core1", "EK2_Core2" };
+static_assert(ARRAY_SIZE(perf_core_names) >= INS_MAX_INSTANCES, "need a perf counter name for each core");
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -527,6 +533,14 @@ const AP_Param::GroupInfo NavEKF2::var_info[] = {
     // @Units: m/s
     AP_GROUPINFO("RNG_USE_SPD", 47, NavEKF2, _useRngSwSpd, 2.0f),
 
+    // @Param: THREADS
+    // @DisplayName: Run EKF cores in parallel
+    // @Description: On Linux boards with more than one CPU this runs the update of each EKF core on its own thread, with each thread pinned to a separate CPU. The results are identical to running the cores one after the other. Has no effect on other boards or with a single core.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("THREADS", 48, NavEKF2, _threads, 0),
+
     AP_GROUPEND
 };
 
@@ -652,6 +666,22 @@ bool NavEKF2::InitialiseFilter(void)
 
         // Set the primary initially to be the lowest index
         primary = 0;
+
+        for (uint8_t i=0; i<num_cores; i++) {
+            _perf_core[i] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, perf_core_names[i]);
+        }
+        _perf_all_cores = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "EK2_AllCores");
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        if (_threads != 0 && num_cores > 1) {
+            _workers = new Linux::WorkerGroup(FUNCTOR_BIND_MEMBER(&NavEKF2::runCoreUpdate, void, uint8_t));
+            if (_workers == nullptr || !_workers->start("ek2_core", num_cores, EK2_WORKER_PRIORITY)) {
+                GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_WARNING, "NavEKF2: failed to start core threads");
+                delete _workers;
+                _workers = nullptr;
+            }
+        }
+#endif
     }
 
     // initialse the cores. We return success only if all cores
@@ -691,7 +721,36 @@ void NavEKF2::UpdateFilter(void)
         } else {
             statePredictEnabled[i] = true;
         }
-        core[i].UpdateFilter(statePredictEnabled[i]);
+        core[i].prepareUpdate(statePredictEnabled[i]);
+    }
+
+    // update the cores, in parallel if the worker threads are running.
+    // The cores share no mutable state, so the results are the same
+    hal.util->perf_begin(_perf_all_cores);
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    if (_workers != nullptr) {
+        _workers->run();
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            runCoreUpdate(i);
+        }
+    }
+    hal.util->perf_end(_perf_all_cores);
+
+    // if we have a 3D fix with no vertical velocity and EK2_GPS_TYPE=0
+    // then change it to 1. It means the GPS is not capable of giving a
+    // vertical velocity. This is done here rather than in the cores so
+    // that all cores see the same setting during an update
+    if (_fusionModeGPS == 0) {
+        for (uint8_t i=0; i<num_cores; i++) {
+            if (core[i].gpsNoVertVelocity()) {
+                _fusionModeGPS.set(1);
+                GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_WARNING, "EK2: Changed EK2_GPS_TYPE to 1");
+                break;
+            }
+        }
     }
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
@@ -736,6 +795,14 @@ void NavEKF2::UpdateFilter(void)
     check_log_write();
 }
 
+// run the filter update for one core
+void NavEKF2::runCoreUpdate(uint8_t i)
+{
+    hal.util->perf_begin(_perf_core[i]);
+    core[i].runUpdate();
+    hal.util->perf_end(_perf_core[i]);
+}
+
 // Check basic filter health metrics and return a consolidated health status
 bool NavEKF2::healthy(void) const
 {
@@ -235,6 +235,7 @@ void NavEKF2_core::InitialiseVariables()
     memset(&gpsloc_prev, 0, sizeof(gpsloc_prev));
     gpsDriftNE = 0.0f;
     gpsVertVelFilt = 0.0f;
+    gpsNoVertVel = false;
     gpsHorizVelFilt = 0.0f;
     memset(&statesArray, 0, sizeof(statesArray));
     posDownDerivative = 0.0f;
@@ -460,8 +461,8 @@ void NavEKF2_core::CovarianceInit()
 /********************************************************
 *                 UPDATE FUNCTIONS                      *
 ********************************************************/
-// Update Filter States - this should be called whenever new IMU data is available
-void NavEKF2_core::UpdateFilter(bool predict)
+// Prepare a filter update - this should be called whenever new IMU data is available
+void NavEKF2_core::prepareUpdate(bool predict)
 {
     // Set the flag to indicate to the filter that the front-end has given permission for a new state prediction cycle to be started
     startPredictEnabled = predict;
@@ -471,12 +472,6 @@ void NavEKF2_core::UpdateFilter(bool predict)
         return;
     }
 
-    // start the timer used for load measurement
-#if EK2_DISABLE_INTERRUPTS
-    irqstate_t istate = irqsave();
-#endif
-    hal.util->perf_begin(_perf_UpdateFilter);
-
     // TODO - in-flight restart method
 
     //get starting time for update step
@@ -487,6 +482,21 @@ void NavEKF2_core::UpdateFilter(bool predict)
 
     // read IMU data as delta angles and velocities
     readIMUData();
+}
+
+// Update Filter States - called after prepareUpdate() once all cores have been prepared
+void NavEKF2_core::runUpdate(void)
+{
+    // don't run filter updates if states have not been initialised
+    if (!statesInitialised) {
+        return;
+    }
+
+    // start the timer used for load measurement
+#if EK2_DISABLE_INTERRUPTS
+    irqstate_t istate = irqsave();
+#endif
+    hal.util->perf_begin(_perf_UpdateFilter);
 
     // Run the EKF equations to estimate at the fusion time horizon if new IMU data is available in the buffer
     if (runUpdates) {
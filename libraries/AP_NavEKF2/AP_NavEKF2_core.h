@@ -60,13 +60,23 @@ public:
     // This method can only be used when the vehicle is static
     bool InitialiseFilterBootstrap(void);
 
-    // Update Filter States - this should be called whenever new IMU data is available
+    // Prepare a filter update - this should be called whenever new IMU data is available
     // The predict flag is set true when a new prediction cycle can be started
-    void UpdateFilter(bool predict);
+    // Cores must be prepared in order, as the frontend uses the result to
+    // decide whether the next core may start a prediction cycle
+    void prepareUpdate(bool predict);
+
+    // Update Filter States - this should be called after prepareUpdate()
+    // This only touches state owned by this core, so the front-end may
+    // run it for several cores in parallel
+    void runUpdate(void);
 
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
+    // return true if the GPS type should be changed to 1 because the GPS is not providing vertical velocity
+    bool gpsNoVertVelocity(void) const { return gpsNoVertVel; }
+
     // Return a consolidated error score where higher numbers are less healthy
     // Intended to be used by the front-end to determine which is the primary EKF
     float errorScore(void) const;
@@ -889,6 +899,7 @@ private:
     uint32_t lastPreAlignGpsCheckTime_ms;   // last time in msec the GPS quality was checked during pre alignment checks
     float gpsDriftNE;               // amount of drift detected in the GPS position during pre-flight GPs checks
     float gpsVertVelFilt;           // amount of filterred vertical GPS velocity detected durng pre-flight GPS checks
+    bool gpsNoVertVel;              // true when GPS_TYPE requires vertical velocity but the 3D fix GPS is not providing it
     float gpsHorizVelFilt;          // amount of filtered horizontal GPS velocity detected during pre-flight GPS checks
 
     // variable used by the in-flight GPS quality check
@@ -27,6 +27,11 @@
 #include <AP_Airspeed/AP_Airspeed.h>
 #include <AP_Compass/AP_Compass.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <AP_HAL_Linux/WorkerGroup.h>
+#endif
 
 class NavEKF3_core;
 class AP_AHRS;
@@ -357,6 +362,7 @@ private:
     AP_Int8  _rngBcnDelay_ms;       // effective average delay of range beacon measurements rel to IMU (msec)
     AP_Float _useRngSwSpd;          // Maximum horizontal ground speed to use range finder as the primary height source (m/s)
     AP_Float _accBiasLim;           // Accelerometer bias limit (m/s/s)
+    AP_Int8 _threads;               // 1 to run the cores on separate threads (Linux only)
 
     // Tuning parameters
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
@@ -386,12 +392,14 @@ private:
     const uint8_t gndGradientSigma;     // RMS terrain gradient percentage assumed by the terrain height estimation
     const uint8_t fusionTimeStep_ms;    // The minimum time interval between covariance predictions and measurement fusions in msec
 
+    // the log_* flags are set by the cores, which may run on separate
+    // threads, so they are kept as separate bytes rather than bitfields
     struct {
-        bool enabled:1;
-        bool log_compass:1;
-        bool log_gps:1;
-        bool log_baro:1;
-        bool log_imu:1;
+        bool enabled;
+        bool log_compass;
+        bool log_gps;
+        bool log_baro;
+        bool log_imu;
     } logging;
 
     // time at start of current filter update
@@ -420,6 +428,18 @@ private:
 
     bool runCoreSelection; // true when the primary core has stabilised and the core selection logic can be started
 
+    // time taken by each core's update and by the update of all cores
+    AP_HAL::Util::perf_counter_t _perf_core[INS_MAX_INSTANCES];
+    AP_HAL::Util::perf_counter_t _perf_all_cores;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // worker threads used to update the cores in parallel when EK3_THREADS is set
+    Linux::WorkerGroup *_workers = nullptr;
+#endif
+
+    // run the filter update for one core, from the main thread or a worker thread
+    void runCoreUpdate(uint8_t i);
+
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
     // old_primary - index of the ekf instance that we are currently using as the primary
@@ -0,0 +1,83 @@
+/*
+  Covariance prediction kernels for the 24 state EKF
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/simd.h>
+
+/*
+  select the covariance prediction engine at build time. The
+  vectorised engine is used by default on Linux boards with SSE or
+  NEON, where running several cores makes the prediction dominate EKF
+  time. Everything else keeps the generated reference code.
+ */
+#ifndef EK3_COV_PREDICT_VECTORISED
+#define EK3_COV_PREDICT_VECTORISED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX && AP_MATH_HAVE_SIMD)
+#endif
+
+class NavEKF3_CovPrediction
+{
+public:
+    typedef float Matrix24[24][24];
+
+    // everything apart from the covariance matrix that the prediction depends on
+    struct Inputs {
+        float dt;               // IMU delta time (sec)
+        Quaternion quat;        // attitude quaternion state
+        Vector3f delAng;        // IMU delta angle (rad)
+        Vector3f delVel;        // IMU delta velocity (m/s)
+        Vector3f gyroBias;      // delta angle bias state (rad)
+        Vector3f accelBias;     // delta velocity bias state (m/s)
+        float dAngVar;          // delta angle noise variance (rad^2)
+        float dVelVar;          // delta velocity noise variance ((m/s)^2)
+    };
+
+    /*
+      Predict the covariance forward using the generated code. Fills
+      the upper triangle of nextP up to and including stateIndexLim,
+      without the state process noise. P must be symmetric.
+     */
+    static void predict_reference(const Matrix24 &P, const Inputs &in, uint8_t stateIndexLim, Matrix24 &nextP);
+
+    /*
+      Equivalent to predict_reference() but evaluates F*P*F' + Q using
+      the sparsity of the state transition matrix F, computing only
+      the upper triangle with 4-wide vector arithmetic.
+     */
+    static void predict_vectorised(const Matrix24 &P, const Inputs &in, uint8_t stateIndexLim, Matrix24 &nextP);
+
+    // predict using the engine selected at build time
+    static void predict(const Matrix24 &P, const Inputs &in, uint8_t stateIndexLim, Matrix24 &nextP) {
+#if EK3_COV_PREDICT_VECTORISED
+        predict_vectorised(P, in, stateIndexLim, nextP);
+#else
+        predict_reference(P, in, stateIndexLim, nextP);
+#endif
+    }
+
+private:
+    // intermediate variables shared by both engines
+    struct Intermediates {
+        float SF[21];
+        float SG[8];
+        float SQ[11];
+        float SPP[11];
+    };
+
+    static void calc_intermediates(const Inputs &in, Intermediates &v);
+};
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <AP_Math/vectorN.h>
 #include <AP_NavEKF3/AP_NavEKF3_Buffer.h>
+#include <AP_NavEKF3/AP_NavEKF3_CovPrediction.h>
 
 // GPS pre-flight check bit locations
 #define MASK_GPS_NSATS      (1<<0)
@@ -73,13 +74,23 @@ public:
     // This method can only be used when the vehicle is static
     bool InitialiseFilterBootstrap(void);
 
-    // Update Filter States - this should be called whenever new IMU data is available
+    // Prepare a filter update - this should be called whenever new IMU data is available
     // The predict flag is set true when a new prediction cycle can be started
-    void UpdateFilter(bool predict);
+    // Cores must be prepared in order, as the frontend uses the result to
+    // decide whether the next core may start a prediction cycle
+    void prepareUpdate(bool predict);
+
+    // Update Filter States - this should be called after prepareUpdate()
+    // This only touches state owned by this core, so the front-end may
+    // run it for several cores in parallel
+    void runUpdate(void);
 
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
+    // return true if the GPS type should be changed to 1 because the GPS is not providing vertical velocity
+    bool gpsNoVertVelocity(void) const { return gpsNoVertVel; }
+
     // Return a consolidated error score where higher numbers are less healthy
     // Intended to be used by the front-end to determine which is the primary EKF
     float errorScore(void) const;
@@ -797,10 +808,6 @@ private:
     uint32_t ekfStartTime_ms;       // time the EKF was started (msec)
     Matrix24 nextP;                 // Predicted covariance matrix before addition of process noise to diagonals
     Vector24 processNoise;          // process noise added to diagonals of predicted covariance matrix
-    Vector21 SF;                    // intermediate variables used to calculate predicted covariance matrix
-    Vector8 SG;                     // intermediate variables used to calculate predicted covariance matrix
-    Vector11 SQ;                    // intermediate variables used to calculate predicted covariance matrix
-    Vector11 SPP;                   // intermediate variables used to calculate predicted covariance matrix
     Vector2f lastKnownPositionNE;   // last known position
     uint32_t lastDecayTime_ms;      // time of last decay of GPS position offset
     float velTestRatio;             // sum of squares of GPS velocity innovation divided by fail threshold
@@ -905,6 +912,7 @@ private:
     uint32_t lastPreAlignGpsCheckTime_ms;   // last time in msec the GPS quality was checked during pre alignment checks
     float gpsDriftNE;               // amount of drift detected in the GPS position during pre-flight GPs checks
     float gpsVertVelFilt;           // amount of filterred vertical GPS velocity detected durng pre-flight GPS checks
+    bool gpsNoVertVel;              // true when GPS_TYPE requires vertical velocity but the 3D fix GPS is not providing it
     float gpsHorizVelFilt;          // amount of filtered horizontal GPS velocity detected during pre-flight GPS checks
 
     // variable used by the in-flight GPS quality check
@@ -0,0 +1,54 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF3/AP_NavEKF3_CovPrediction.h>
+
+typedef NavEKF3_CovPrediction::Matrix24 Matrix24;
+
+static void setup(Matrix24 &P, NavEKF3_CovPrediction::Inputs &in)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            P[i][j] = (i == j) ? 1e-2f : 1e-5f;
+        }
+    }
+    in.dt = 0.0025f;
+    in.quat = Quaternion(0.9f, 0.1f, 0.2f, 0.3f);
+    in.quat.normalize();
+    in.delAng = Vector3f(1e-3f, -2e-3f, 5e-4f);
+    in.delVel = Vector3f(1e-3f, 2e-3f, -GRAVITY_MSS * in.dt);
+    in.gyroBias = Vector3f(1e-5f, -1e-5f, 2e-5f);
+    in.accelBias = Vector3f(1e-4f, 1e-4f, -1e-4f);
+    in.dAngVar = sq(in.dt * 0.015f);
+    in.dVelVar = sq(in.dt * 0.35f);
+}
+
+static void BM_CovPredictionReference(benchmark::State& state)
+{
+    Matrix24 P;
+    Matrix24 nextP;
+    NavEKF3_CovPrediction::Inputs in;
+    setup(P, in);
+
+    while (state.KeepRunning()) {
+        NavEKF3_CovPrediction::predict_reference(P, in, state.range_x(), nextP);
+        gbenchmark_escape(&nextP);
+    }
+}
+
+static void BM_CovPredictionVectorised(benchmark::State& state)
+{
+    Matrix24 P;
+    Matrix24 nextP;
+    NavEKF3_CovPrediction::Inputs in;
+    setup(P, in);
+
+    while (state.KeepRunning()) {
+        NavEKF3_CovPrediction::predict_vectorised(P, in, state.range_x(), nextP);
+        gbenchmark_escape(&nextP);
+    }
+}
+
+BENCHMARK(BM_CovPredictionReference)->Arg(15)->Arg(21)->Arg(23);
+BENCHMARK(BM_CovPredictionVectorised)->Arg(15)->Arg(21)->Arg(23);
+
+BENCHMARK_MAIN()
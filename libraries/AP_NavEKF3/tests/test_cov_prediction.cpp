@@ -0,0 +1,78 @@
+#include <AP_gtest.h>
+
+#include <stdlib.h>
+#include <AP_NavEKF3/AP_NavEKF3_CovPrediction.h>
+
+typedef NavEKF3_CovPrediction::Matrix24 Matrix24;
+
+static float random_float(float scale)
+{
+    return scale * (2.0f * (float)rand() / (float)RAND_MAX - 1.0f);
+}
+
+// build a random symmetric positive definite covariance as L*L'
+static void random_covariance(Matrix24 &P)
+{
+    Matrix24 L;
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            L[i][j] = random_float(0.1f);
+        }
+    }
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            double sum = 0;
+            for (uint8_t k=0; k<24; k++) {
+                sum += (double)L[i][k] * L[j][k];
+            }
+            P[i][j] = sum;
+        }
+    }
+}
+
+static void random_inputs(NavEKF3_CovPrediction::Inputs &in)
+{
+    in.dt = 0.0025f;
+    in.quat = Quaternion(1.0f, random_float(0.3f), random_float(0.3f), random_float(0.3f));
+    in.quat.normalize();
+    in.delAng = Vector3f(random_float(0.01f), random_float(0.01f), random_float(0.01f));
+    in.delVel = Vector3f(random_float(0.01f), random_float(0.01f), random_float(0.01f) - GRAVITY_MSS * in.dt);
+    in.gyroBias = Vector3f(random_float(1e-4f), random_float(1e-4f), random_float(1e-4f));
+    in.accelBias = Vector3f(random_float(1e-3f), random_float(1e-3f), random_float(1e-3f));
+    in.dAngVar = sq(in.dt * 0.015f);
+    in.dVelVar = sq(in.dt * 0.35f);
+}
+
+class CovPredictionTest : public ::testing::TestWithParam<uint8_t> {};
+
+TEST_P(CovPredictionTest, VectorisedMatchesReference)
+{
+    const uint8_t stateIndexLim = GetParam();
+    Matrix24 P;
+    Matrix24 nextP_ref;
+    Matrix24 nextP_vec;
+    NavEKF3_CovPrediction::Inputs in;
+
+    srand(stateIndexLim);
+    for (uint8_t trial=0; trial<50; trial++) {
+        random_covariance(P);
+        random_inputs(in);
+        memset(nextP_ref, 0, sizeof(nextP_ref));
+        memset(nextP_vec, 0, sizeof(nextP_vec));
+
+        NavEKF3_CovPrediction::predict_reference(P, in, stateIndexLim, nextP_ref);
+        NavEKF3_CovPrediction::predict_vectorised(P, in, stateIndexLim, nextP_vec);
+
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            for (uint8_t j=i; j<=stateIndexLim; j++) {
+                // the engines sum in a different order, allow for float rounding
+                const float tolerance = 1e-5f * MAX(fabsf(nextP_ref[i][j]), 1e-2f);
+                EXPECT_NEAR(nextP_ref[i][j], nextP_vec[i][j], tolerance) << "i=" << (int)i << " j=" << (int)j;
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(StateIndexLimits, CovPredictionTest, ::testing::Values(15, 21, 23));
+
+AP_GTEST_MAIN()
@@ -62,6 +62,34 @@ uint16_t AP_Param::_num_vars;
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
 
+AP_HAL::Semaphore *AP_Param::_storage_sem;
+
+#if AP_PARAM_STORAGE_INDEX
+// sorted index of header offsets in storage, built by load_all()
+struct AP_Param::storage_index_entry *AP_Param::_storage_index;
+uint16_t AP_Param::_storage_index_count;
+uint16_t AP_Param::_storage_index_size;
+uint16_t AP_Param::_storage_end;
+bool AP_Param::_storage_index_valid;
+#endif
+
+#if AP_PARAM_DEFERRED_SAVE
+// variables waiting to be written by the IO thread
+struct AP_Param::param_save AP_Param::_save_queue[AP_PARAM_SAVE_QUEUE_SIZE];
+uint8_t AP_Param::_save_queue_count;
+AP_HAL::Semaphore *AP_Param::_save_sem;
+
+// object to bind the IO thread callback to
+static AP_Param save_dummy;
+#endif
+
+#if AP_PARAM_NAME_INDEX
+// sorted index of scalar parameter names, built on first use
+struct AP_Param::name_index_entry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+bool AP_Param::_name_index_valid;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -96,6 +124,8 @@ void AP_Param::erase_all(void)
 {
     struct EEPROM_header hdr;
 
+    storage_lock();
+
     // write the header
     hdr.magic[0] = k_EEPROM_magic0;
     hdr.magic[1] = k_EEPROM_magic1;
@@ -105,6 +135,15 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_STORAGE_INDEX
+    // storage is now empty, so the index is trivially correct
+    _storage_index_count = 0;
+    _storage_end = sizeof(struct EEPROM_header);
+    _storage_index_valid = true;
+#endif
+
+    storage_unlock();
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -589,6 +628,25 @@ bool AP_Param::is_sentinal(const Param_header &phdr)
 // if the sentinal isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+    storage_lock();
+    bool ret = scan_nolock(target, pofs);
+    storage_unlock();
+    return ret;
+}
+
+// scan() for callers already holding the storage lock
+bool AP_Param::scan_nolock(const AP_Param::Param_header *target, uint16_t *pofs)
+{
+#if AP_PARAM_STORAGE_INDEX
+    if (_storage_index_valid) {
+        if (storage_index_find(*target, *pofs)) {
+            return true;
+        }
+        *pofs = _storage_end;
+        return false;
+    }
+#endif
+
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -612,6 +670,100 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+void AP_Param::storage_lock(void)
+{
+    if (_storage_sem != nullptr && !_storage_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        AP_HAL::panic("AP_Param: failed to take storage semaphore");
+    }
+}
+
+void AP_Param::storage_unlock(void)
+{
+    if (_storage_sem != nullptr) {
+        _storage_sem->give();
+    }
+}
+
+#if AP_PARAM_STORAGE_INDEX
+/*
+  the 32 bit identity of a stored variable. This is the 9 bit key,
+  5 bit type and 18 bit group element, which is everything scan()
+  matches on
+ */
+uint32_t AP_Param::storage_id(const Param_header &phdr)
+{
+    return (((uint32_t)get_key(phdr)) << 23) | (((uint32_t)phdr.type) << 18) | phdr.group_element;
+}
+
+/*
+  find the storage offset of a header using the index
+ */
+bool AP_Param::storage_index_find(const Param_header &phdr, uint16_t &ofs)
+{
+    const uint32_t id = storage_id(phdr);
+    uint16_t lo = 0, hi = _storage_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_storage_index[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < _storage_index_count && _storage_index[lo].id == id) {
+        ofs = _storage_index[lo].ofs;
+        return true;
+    }
+    return false;
+}
+
+/*
+  add a header to the index. If the header is already indexed the
+  existing offset is kept, matching a linear scan which stops at the
+  first copy. Returns false if the index could not be grown
+ */
+bool AP_Param::storage_index_add(const Param_header &phdr, uint16_t ofs)
+{
+    const uint32_t id = storage_id(phdr);
+    uint16_t lo = 0, hi = _storage_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_storage_index[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < _storage_index_count && _storage_index[lo].id == id) {
+        return true;
+    }
+    if (_storage_index_count == _storage_index_size) {
+        uint16_t new_size = _storage_index_size == 0 ? 64 : _storage_index_size * 2;
+        struct storage_index_entry *new_index =
+            (struct storage_index_entry *)realloc(_storage_index, new_size * sizeof(_storage_index[0]));
+        if (new_index == nullptr) {
+            return false;
+        }
+        _storage_index = new_index;
+        _storage_index_size = new_size;
+    }
+    memmove(&_storage_index[lo+1], &_storage_index[lo], (_storage_index_count - lo) * sizeof(_storage_index[0]));
+    _storage_index[lo].id = id;
+    _storage_index[lo].ofs = ofs;
+    _storage_index_count++;
+    return true;
+}
+
+/*
+  stop using the index, falling back to scanning storage
+ */
+void AP_Param::storage_index_invalidate(void)
+{
+    _storage_index_valid = false;
+    _storage_index_count = 0;
+}
+#endif // AP_PARAM_STORAGE_INDEX
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -735,10 +887,144 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
+#if AP_PARAM_NAME_INDEX
+/*
+  32 bit FNV-1a hash of a parameter name
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t hash = 2166136261U;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/*
+  build the name index by walking all scalar parameters. Vector3f
+  parameters are indexed by their _X, _Y and _Z element names, so only
+  a lookup of a whole vector needs to fall back to find_linear()
+ */
+void AP_Param::build_name_index(void)
+{
+    _name_index_valid = true;
+    _name_index_count = 0;
+    if (_num_vars == 0) {
+        return;
+    }
+
+    uint16_t count = count_parameters();
+    _name_index = (struct name_index_entry *)calloc(count, sizeof(struct name_index_entry));
+    if (_name_index == nullptr) {
+        return;
+    }
+
+    ParamToken token;
+    enum ap_var_type type;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && _name_index_count < count;
+         ap = next_scalar(&token, &type)) {
+        if (type > AP_PARAM_FLOAT) {
+            continue;
+        }
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        if (name[0] == 0) {
+            continue;
+        }
+        const uint32_t hash = name_hash(name);
+
+        // insert after any entries of equal hash so that duplicate
+        // names resolve the same way as find_linear()
+        uint16_t lo = 0, hi = _name_index_count;
+        while (lo < hi) {
+            uint16_t mid = (lo + hi) / 2;
+            if (_name_index[mid].hash <= hash) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        memmove(&_name_index[lo+1], &_name_index[lo], (_name_index_count - lo) * sizeof(_name_index[0]));
+        _name_index[lo].hash = hash;
+        _name_index[lo].token = token;
+        _name_index[lo].ap = ap;
+        _name_index[lo].type = type;
+        _name_index_count++;
+    }
+}
+
+/*
+  discard the name index. It is rebuilt on the next find()
+ */
+void AP_Param::invalidate_name_index(void)
+{
+    free(_name_index);
+    _name_index = nullptr;
+    _name_index_count = 0;
+    _name_index_valid = false;
+}
+
+/*
+  find a variable using the name index. Returns nullptr if the name is
+  not in the index, in which case the caller should fall back to
+  find_linear()
+ */
+AP_Param *AP_Param::find_indexed(const char *name, enum ap_var_type *ptype)
+{
+    if (!_name_index_valid) {
+        build_name_index();
+    }
+    if (_name_index_count == 0) {
+        return nullptr;
+    }
+
+    const uint32_t hash = name_hash(name);
+    uint16_t lo = 0, hi = _name_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // check the name of each candidate to rule out hash collisions
+    for (; lo < _name_index_count && _name_index[lo].hash == hash; lo++) {
+        const struct name_index_entry &e = _name_index[lo];
+        char ename[AP_MAX_NAME_SIZE+1];
+        e.ap->copy_name_token(e.token, ename, sizeof(ename), true);
+        ename[AP_MAX_NAME_SIZE] = 0;
+        if (strcmp(name, ename) == 0) {
+            *ptype = (enum ap_var_type)e.type;
+            return e.ap;
+        }
+    }
+    return nullptr;
+}
+#endif // AP_PARAM_NAME_INDEX
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
+{
+#if AP_PARAM_NAME_INDEX
+    AP_Param *ap = find_indexed(name, ptype);
+    if (ap != nullptr) {
+        return ap;
+    }
+#endif
+    return find_linear(name, ptype);
+}
+
+// Find a variable by name, walking the whole _var_info table
+//
+AP_Param *
+AP_Param::find_linear(const char *name, enum ap_var_type *ptype)
 {
     for (uint16_t i=0; i<_num_vars; i++) {
         uint8_t type = _var_info[i].type;
@@ -914,6 +1200,47 @@ void AP_Param::notify() const {
 // Save the variable to EEPROM, if supported
 //
 bool AP_Param::save(bool force_save)
+{
+#if AP_PARAM_DEFERRED_SAVE
+    if (_save_sem != nullptr) {
+        uint32_t group_element = 0;
+        const struct GroupInfo *ginfo;
+        struct GroupNesting group_nesting {};
+        uint8_t idx;
+        const struct AP_Param::Info *info = find_var_info(&group_element, ginfo, group_nesting, &idx);
+        if (info == nullptr) {
+            // we don't have any info on how to store it
+            return false;
+        }
+        enum ap_var_type type = (enum ap_var_type)(ginfo != nullptr ? ginfo->type : info->type);
+        if (type != AP_PARAM_VECTOR3F && idx != 0) {
+            // only vector3f can have non-zero idx for now
+            return false;
+        }
+        if (type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
+            // clear cached parameter count
+            _parameter_count = 0;
+#if AP_PARAM_NAME_INDEX
+            invalidate_name_index();
+#endif
+        }
+        if (queue_save(this, force_save)) {
+            char name[AP_MAX_NAME_SIZE+1];
+            copy_name_info(info, ginfo, group_nesting, idx, name, sizeof(name), true);
+            send_parameter(name, type, idx);
+            return true;
+        }
+        // the queue is full, save it now rather than lose it
+    }
+#endif
+    return save_sync(force_save, false);
+}
+
+// Save the variable to EEPROM on the calling thread. When deferred
+// is set save() has already updated the GCS and the cached parameter
+// count, so we only write to storage
+//
+bool AP_Param::save_sync(bool force_save, bool deferred)
 {
     uint32_t group_element = 0;
     const struct GroupInfo *ginfo;
@@ -947,23 +1274,32 @@ bool AP_Param::save(bool force_save)
         ap = (const AP_Param *)((ptrdiff_t)ap) - (idx*sizeof(float));
     }
 
-    if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
+    if (!deferred && phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
         // clear cached parameter count
         _parameter_count = 0;
+#if AP_PARAM_NAME_INDEX
+        invalidate_name_index();
+#endif
     }
     
     char name[AP_MAX_NAME_SIZE+1];
     copy_name_info(info, ginfo, group_nesting, idx, name, sizeof(name), true);
 
+    storage_lock();
+
     // scan EEPROM to find the right location
     uint16_t ofs;
-    if (scan(&phdr, &ofs)) {
+    if (scan_nolock(&phdr, &ofs)) {
         // found an existing copy of the variable
         eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
-        send_parameter(name, (enum ap_var_type)phdr.type, idx);
+        storage_unlock();
+        if (!deferred) {
+            send_parameter(name, (enum ap_var_type)phdr.type, idx);
+        }
         return true;
     }
     if (ofs == (uint16_t) ~0) {
+        storage_unlock();
         return false;
     }
 
@@ -977,7 +1313,10 @@ bool AP_Param::save(bool force_save)
             v2 = get_default_value(&info->def_value);
         }
         if (is_equal(v1,v2) && !force_save) {
-            GCS_MAVLINK::send_parameter_value_all(name, (enum ap_var_type)info->type, v2);
+            storage_unlock();
+            if (!deferred) {
+                GCS_MAVLINK::send_parameter_value_all(name, (enum ap_var_type)info->type, v2);
+            }
             return true;
         }
         if (!force_save &&
@@ -985,26 +1324,141 @@ bool AP_Param::save(bool force_save)
              (fabsf(v1-v2) < 0.0001f*fabsf(v1)))) {
             // for other than 32 bit integers, we accept values within
             // 0.01 percent of the current value as being the same
-            GCS_MAVLINK::send_parameter_value_all(name, (enum ap_var_type)info->type, v2);
+            storage_unlock();
+            if (!deferred) {
+                GCS_MAVLINK::send_parameter_value_all(name, (enum ap_var_type)info->type, v2);
+            }
             return true;
         }
     }
 
     if (ofs+type_size((enum ap_var_type)phdr.type)+2*sizeof(phdr) >= _storage.size()) {
         // we are out of room for saving variables
+        storage_unlock();
         hal.console->println("EEPROM full");
         return false;
     }
 
     // write a new sentinal, then the data, then the header
-    write_sentinal(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
+    const uint16_t new_end = ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type);
+    write_sentinal(new_end);
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
 
-    send_parameter(name, (enum ap_var_type)phdr.type, idx);
+#if AP_PARAM_STORAGE_INDEX
+    if (_storage_index_valid) {
+        if (storage_index_add(phdr, ofs)) {
+            _storage_end = new_end;
+        } else {
+            storage_index_invalidate();
+        }
+    }
+#endif
+
+    storage_unlock();
+
+    if (!deferred) {
+        send_parameter(name, (enum ap_var_type)phdr.type, idx);
+    }
     return true;
 }
 
+#if AP_PARAM_DEFERRED_SAVE
+/*
+  create the save queue and start writing it from the IO thread
+ */
+void AP_Param::start_deferred_save(void)
+{
+    if (_save_sem != nullptr) {
+        return;
+    }
+    AP_HAL::Semaphore *storage_sem = hal.util->new_semaphore();
+    AP_HAL::Semaphore *save_sem = hal.util->new_semaphore();
+    if (storage_sem == nullptr || save_sem == nullptr) {
+        delete storage_sem;
+        delete save_sem;
+        return;
+    }
+    _storage_sem = storage_sem;
+    _save_sem = save_sem;
+    hal.scheduler->register_io_process(FUNCTOR_BIND(&save_dummy, &AP_Param::save_io_handler, void));
+}
+
+/*
+  add a variable to the save queue. A variable already in the queue is
+  not added again, as the IO thread saves its value at the time it is
+  written. Returns false if the queue is full
+ */
+bool AP_Param::queue_save(AP_Param *param, bool force_save)
+{
+    if (!_save_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return false;
+    }
+    bool ret = true;
+    uint8_t i;
+    for (i=0; i<_save_queue_count; i++) {
+        if (_save_queue[i].param == param) {
+            _save_queue[i].force_save |= force_save;
+            break;
+        }
+    }
+    if (i == _save_queue_count) {
+        if (_save_queue_count < AP_PARAM_SAVE_QUEUE_SIZE) {
+            _save_queue[_save_queue_count].param = param;
+            _save_queue[_save_queue_count].force_save = force_save;
+            _save_queue_count++;
+        } else {
+            ret = false;
+        }
+    }
+    _save_sem->give();
+    return ret;
+}
+
+/*
+  take the oldest variable off the save queue
+ */
+bool AP_Param::pop_save(struct param_save &p)
+{
+    if (!_save_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return false;
+    }
+    bool ret = false;
+    if (_save_queue_count > 0) {
+        p = _save_queue[0];
+        _save_queue_count--;
+        memmove(&_save_queue[0], &_save_queue[1], _save_queue_count * sizeof(_save_queue[0]));
+        ret = true;
+    }
+    _save_sem->give();
+    return ret;
+}
+
+/*
+  write queued variables from the IO thread. The GCS has already been
+  told about the new values by save()
+ */
+void AP_Param::save_io_handler(void)
+{
+    struct param_save p;
+    while (pop_save(p)) {
+        p.param->save_sync(p.force_save, true);
+    }
+}
+#endif // AP_PARAM_DEFERRED_SAVE
+
+/*
+  write any queued variables to storage on the calling thread
+ */
+void AP_Param::flush(void)
+{
+#if AP_PARAM_DEFERRED_SAVE
+    if (_save_sem != nullptr) {
+        save_dummy.save_io_handler();
+    }
+#endif
+}
+
 // Load the variable from EEPROM, if supported
 //
 bool AP_Param::load(void)
@@ -1216,12 +1670,31 @@ bool AP_Param::load_all(bool check_defaults_file)
 
     reload_defaults_file(check_defaults_file);
 
+#if AP_PARAM_DEFERRED_SAVE
+    start_deferred_save();
+#endif
+
+    storage_lock();
+
+#if AP_PARAM_STORAGE_INDEX
+    // rebuild the storage index as we walk the headers
+    storage_index_invalidate();
+    bool index_ok = true;
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         // note that this is an || not an && for robustness
         // against power off while adding a variable
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
+#if AP_PARAM_STORAGE_INDEX
+            if (index_ok) {
+                _storage_end = ofs;
+                _storage_index_valid = true;
+            }
+#endif
+            storage_unlock();
             return true;
         }
 
@@ -1233,9 +1706,17 @@ bool AP_Param::load_all(bool check_defaults_file)
             _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
         }
 
+#if AP_PARAM_STORAGE_INDEX
+        if (index_ok) {
+            index_ok = storage_index_add(phdr, ofs);
+        }
+#endif
+
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
+    storage_unlock();
+
     // we didn't find the sentinal
     Debug("no sentinal in load_all");
     return false;
@@ -1246,6 +1727,12 @@ bool AP_Param::load_all(bool check_defaults_file)
  */
 void AP_Param::reload_defaults_file(bool panic_on_error)
 {
+#if AP_PARAM_NAME_INDEX
+    // pointer parameter objects may have been allocated since the
+    // name index was built
+    invalidate_name_index();
+#endif
+
 #if HAL_OS_POSIX_IO == 1
     /*
       if the HAL specifies a defaults parameter file then override
@@ -1287,6 +1774,7 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
             continue;
         }
         uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+        storage_lock();
         while (ofs < _storage.size()) {
             _storage.read_block(&phdr, ofs, sizeof(phdr));
             // note that this is an || not an && for robustness
@@ -1309,6 +1797,7 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
             }
             ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
         }
+        storage_unlock();
     }
 }
 
@@ -31,6 +31,36 @@
 
 #define AP_MAX_NAME_SIZE 16
 
+/*
+  keep a hash index of parameter names so find() does not need to walk
+  the whole var_info tree. This costs around 16 bytes of RAM per
+  parameter, so is only enabled by default on boards with plenty of
+  memory
+ */
+#ifndef AP_PARAM_NAME_INDEX
+#define AP_PARAM_NAME_INDEX (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+/*
+  keep an index of where each parameter header lives in storage, so
+  save() and load() don't need to walk storage from the start for
+  every variable
+ */
+#ifndef AP_PARAM_STORAGE_INDEX
+#define AP_PARAM_STORAGE_INDEX (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+/*
+  queue save() calls and write them to storage from the IO thread,
+  merging repeated saves of the same variable
+ */
+#ifndef AP_PARAM_DEFERRED_SAVE
+#define AP_PARAM_DEFERRED_SAVE (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// number of variables that can be waiting to be saved
+#define AP_PARAM_SAVE_QUEUE_SIZE 32
+
 /*
   flags for variables in var_info and group tables
  */
@@ -202,6 +232,12 @@ public:
     ///
     static AP_Param * find(const char *name, enum ap_var_type *ptype);
 
+    /// Find a variable by name without using the name index. This
+    /// walks the whole _var_info table and is mostly useful to
+    /// measure the index against.
+    ///
+    static AP_Param * find_linear(const char *name, enum ap_var_type *ptype);
+
     /// set a default value by name
     ///
     /// @param  name            The full name of the variable to be found.
@@ -242,12 +278,20 @@ public:
     
     /// Save the current value of the variable to EEPROM.
     ///
+    /// When deferred saves are enabled the variable is queued and
+    /// written by the IO thread, and the return value only says
+    /// whether it was queued.
+    ///
     /// @param  force_save     If true then force save even if default
     ///
     /// @return                True if the variable was saved successfully.
     ///
     bool save(bool force_save=false);
 
+    /// Write any variables waiting in the save queue to EEPROM
+    ///
+    static void flush(void);
+
     /// Load the variable from EEPROM.
     ///
     /// @return                True if the variable was loaded successfully.
@@ -480,6 +524,75 @@ private:
     */
     static const float *find_def_value_ptr(const char *name);
 
+    // save the variable to storage on the calling thread
+    bool save_sync(bool force_save, bool deferred);
+
+    static bool scan_nolock(const struct Param_header *phdr, uint16_t *pofs);
+
+#if AP_PARAM_STORAGE_INDEX
+    /*
+      an entry in the storage index. Entries are sorted by the
+      storage_id() of the header
+    */
+    struct storage_index_entry {
+        uint32_t id;
+        uint16_t ofs;
+    };
+    static uint32_t storage_id(const Param_header &phdr);
+    static bool storage_index_find(const Param_header &phdr, uint16_t &ofs);
+    static bool storage_index_add(const Param_header &phdr, uint16_t ofs);
+    static void storage_index_invalidate(void);
+
+    static struct storage_index_entry *_storage_index;
+    static uint16_t _storage_index_count;
+    static uint16_t _storage_index_size;
+    // offset of the sentinal when the index is valid
+    static uint16_t _storage_end;
+    static bool _storage_index_valid;
+#endif
+
+    // protects storage and the storage index when saves are deferred
+    static AP_HAL::Semaphore *_storage_sem;
+    static void storage_lock(void);
+    static void storage_unlock(void);
+
+#if AP_PARAM_DEFERRED_SAVE
+    struct param_save {
+        AP_Param *param;
+        bool force_save;
+    };
+    static void start_deferred_save(void);
+    static bool queue_save(AP_Param *param, bool force_save);
+    static bool pop_save(struct param_save &p);
+    void save_io_handler(void);
+
+    static struct param_save _save_queue[AP_PARAM_SAVE_QUEUE_SIZE];
+    static uint8_t _save_queue_count;
+    static AP_HAL::Semaphore *_save_sem;
+#endif
+
+#if AP_PARAM_NAME_INDEX
+    /*
+      an entry in the name index. Entries are sorted by the hash of
+      the full scalar name, with entries of equal hash kept in
+      _var_info order
+    */
+    struct name_index_entry {
+        uint32_t hash;
+        ParamToken token;
+        AP_Param *ap;
+        uint8_t type;
+    };
+    static uint32_t name_hash(const char *name);
+    static void build_name_index(void);
+    static void invalidate_name_index(void);
+    static AP_Param *find_indexed(const char *name, enum ap_var_type *ptype);
+
+    static struct name_index_entry *_name_index;
+    static uint16_t _name_index_count;
+    static bool _name_index_valid;
+#endif
+
 #if HAL_OS_POSIX_IO == 1
     /*
       load a parameter defaults file. This happens as part of load_all()
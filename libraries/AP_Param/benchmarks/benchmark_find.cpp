@@ -0,0 +1,92 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+/*
+  a parameter tree roughly the size of a copter build: a format
+  version followed by 48 groups of 16 floats and a vector, giving 913
+  scalar parameters
+ */
+class BenchParams {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Float p[16];
+    AP_Vector3f v;
+};
+
+const AP_Param::GroupInfo BenchParams::var_info[] = {
+    AP_GROUPINFO("GAIN_P",   0, BenchParams, p[0],  0),
+    AP_GROUPINFO("GAIN_I",   1, BenchParams, p[1],  0),
+    AP_GROUPINFO("GAIN_D",   2, BenchParams, p[2],  0),
+    AP_GROUPINFO("GAIN_FF",  3, BenchParams, p[3],  0),
+    AP_GROUPINFO("IMAX",     4, BenchParams, p[4],  0),
+    AP_GROUPINFO("FILT",     5, BenchParams, p[5],  0),
+    AP_GROUPINFO("RATE_MAX", 6, BenchParams, p[6],  0),
+    AP_GROUPINFO("ACC_MAX",  7, BenchParams, p[7],  0),
+    AP_GROUPINFO("TAU",      8, BenchParams, p[8],  0),
+    AP_GROUPINFO("SCALE",    9, BenchParams, p[9],  0),
+    AP_GROUPINFO("OFFSET",  10, BenchParams, p[10], 0),
+    AP_GROUPINFO("MIN",     11, BenchParams, p[11], 0),
+    AP_GROUPINFO("MAX",     12, BenchParams, p[12], 0),
+    AP_GROUPINFO("TRIM",    13, BenchParams, p[13], 0),
+    AP_GROUPINFO("DZ",      14, BenchParams, p[14], 0),
+    AP_GROUPINFO("EXPO",    15, BenchParams, p[15], 0),
+    AP_GROUPINFO("OFS",     16, BenchParams, v,     0),
+    AP_GROUPEND
+};
+
+static AP_Int16 format_version;
+static BenchParams bench_params[48];
+
+#define BENCH_GROUP(n, name) { AP_PARAM_GROUP, name, n, &bench_params[n], {group_info : BenchParams::var_info} }
+
+static const AP_Param::Info var_info[] = {
+    { AP_PARAM_INT16, "FORMAT_VERSION", 48, &format_version, {def_value : 0} },
+    BENCH_GROUP(0,  "A0_"), BENCH_GROUP(1,  "A1_"), BENCH_GROUP(2,  "A2_"), BENCH_GROUP(3,  "A3_"),
+    BENCH_GROUP(4,  "A4_"), BENCH_GROUP(5,  "A5_"), BENCH_GROUP(6,  "A6_"), BENCH_GROUP(7,  "A7_"),
+    BENCH_GROUP(8,  "B0_"), BENCH_GROUP(9,  "B1_"), BENCH_GROUP(10, "B2_"), BENCH_GROUP(11, "B3_"),
+    BENCH_GROUP(12, "B4_"), BENCH_GROUP(13, "B5_"), BENCH_GROUP(14, "B6_"), BENCH_GROUP(15, "B7_"),
+    BENCH_GROUP(16, "C0_"), BENCH_GROUP(17, "C1_"), BENCH_GROUP(18, "C2_"), BENCH_GROUP(19, "C3_"),
+    BENCH_GROUP(20, "C4_"), BENCH_GROUP(21, "C5_"), BENCH_GROUP(22, "C6_"), BENCH_GROUP(23, "C7_"),
+    BENCH_GROUP(24, "D0_"), BENCH_GROUP(25, "D1_"), BENCH_GROUP(26, "D2_"), BENCH_GROUP(27, "D3_"),
+    BENCH_GROUP(28, "D4_"), BENCH_GROUP(29, "D5_"), BENCH_GROUP(30, "D6_"), BENCH_GROUP(31, "D7_"),
+    BENCH_GROUP(32, "E0_"), BENCH_GROUP(33, "E1_"), BENCH_GROUP(34, "E2_"), BENCH_GROUP(35, "E3_"),
+    BENCH_GROUP(36, "E4_"), BENCH_GROUP(37, "E5_"), BENCH_GROUP(38, "E6_"), BENCH_GROUP(39, "E7_"),
+    BENCH_GROUP(40, "F0_"), BENCH_GROUP(41, "F1_"), BENCH_GROUP(42, "F2_"), BENCH_GROUP(43, "F3_"),
+    BENCH_GROUP(44, "F4_"), BENCH_GROUP(45, "F5_"), BENCH_GROUP(46, "F6_"), BENCH_GROUP(47, "F7_"),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+// names near the start, middle and end of the tree
+static const char *names[] = { "A0_GAIN_P", "D0_TRIM", "F7_OFS_Z" };
+
+static void BM_ParamFindLinear(benchmark::State& state)
+{
+    const char *name = names[state.range_x()];
+    enum ap_var_type ptype;
+
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_linear(name, &ptype);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFind(benchmark::State& state)
+{
+    const char *name = names[state.range_x()];
+    enum ap_var_type ptype;
+
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find(name, &ptype);
+        gbenchmark_escape(vp);
+    }
+}
+
+BENCHMARK(BM_ParamFindLinear)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(BM_ParamFind)->Arg(0)->Arg(1)->Arg(2);
+
+BENCHMARK_MAIN()
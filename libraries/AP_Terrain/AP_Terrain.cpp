@@ -50,6 +50,24 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: Number of terrain grid blocks kept in memory. Each grid block uses about 2 kilobytes of memory. A larger cache reduces waiting for the SD card on long missions over rough terrain. A reboot is required for changes to take effect.
+    // @Range: 4 200
+    // @Increment: 1
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, cache_size_param, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
+    // @Param: PREFETCH
+    // @DisplayName: Terrain prefetch time
+    // @Description: Number of seconds of flight ahead of the vehicle for which terrain grid blocks are loaded from the SD card before they are needed. The path ahead follows the mission when in auto, otherwise the current velocity. Set to zero to disable prefetching.
+    // @Units: seconds
+    // @Range: 0 600
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("PREFETCH",  3, AP_Terrain, prefetch_time, 60),
+
     AP_GROUPEND
 };
 
@@ -325,6 +343,9 @@ void AP_Terrain::update(void)
     // check for pending mission data
     update_mission_data();
 
+    // load grid blocks ahead of the vehicle
+    update_prefetch();
+
     // check for pending rally data
     update_rally_data();
 
@@ -381,6 +402,25 @@ void AP_Terrain::log_terrain_data(DataFlash_Class &dataflash)
         loaded         : loaded
     };
     dataflash.WriteBlock(&pkt, sizeof(pkt));
+
+    struct log_TERRAIN_CACHE pkt2 = {
+        LOG_PACKET_HEADER_INIT(LOG_TERRAIN_CACHE_MSG),
+        time_us        : AP_HAL::micros64(),
+        hits           : cache_stats.hits,
+        misses         : cache_stats.misses,
+        evictions      : cache_stats.evictions,
+        prefetches     : cache_stats.prefetches,
+        prefetch_hits  : cache_stats.prefetch_hits,
+        read_avg_ms    : (uint16_t)MIN(cache_stats.read_count ? cache_stats.read_total_ms / cache_stats.read_count : 0, (uint32_t)UINT16_MAX),
+        read_max_ms    : (uint16_t)MIN(cache_stats.read_max_ms, (uint32_t)UINT16_MAX),
+        cache_size     : cache_size
+    };
+    dataflash.WriteBlock(&pkt2, sizeof(pkt2));
+
+    // read latency is reported per message
+    cache_stats.read_count = 0;
+    cache_stats.read_total_ms = 0;
+    cache_stats.read_max_ms = 0;
 }
 
 /*
@@ -395,13 +435,40 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
-    if (cache == nullptr) {
+    uint16_t size = constrain_int16(cache_size_param, TERRAIN_GRID_BLOCK_CACHE_MIN, TERRAIN_GRID_BLOCK_CACHE_MAX);
+
+    // use a power of two hash table with at least twice as many
+    // buckets as blocks, to keep the chains short
+    uint16_t buckets = 1;
+    while (buckets < 2*size) {
+        buckets <<= 1;
+    }
+
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    hash_table = (uint16_t *)malloc(buckets * sizeof(hash_table[0]));
+    if (cache == nullptr || hash_table == nullptr) {
+        free(cache);
+        free(hash_table);
+        cache = nullptr;
+        hash_table = nullptr;
         enable.set(0);
         GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    for (uint16_t i=0; i<buckets; i++) {
+        hash_table[i] = TERRAIN_CACHE_NONE;
+    }
+    hash_mask = buckets - 1;
+
+    // all blocks start out unused and unhashed, in LRU order
+    for (uint16_t i=0; i<size; i++) {
+        cache[i].hash_next = TERRAIN_CACHE_NONE;
+        cache[i].lru_prev = (i == 0) ? TERRAIN_CACHE_NONE : i-1;
+        cache[i].lru_next = (i == size-1) ? TERRAIN_CACHE_NONE : i+1;
+    }
+    lru_head = 0;
+    lru_tail = size-1;
+    cache_size = size;
     return true;
 }
 
@@ -52,9 +52,22 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+// limits on the TERRAIN_CACHE_SZ parameter
+#define TERRAIN_GRID_BLOCK_CACHE_MIN 4
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 200
+
+// marks the end of the LRU list and hash chains
+#define TERRAIN_CACHE_NONE 0xFFFF
+
+// how often to look for grid_blocks to prefetch
+#define TERRAIN_PREFETCH_INTERVAL_MS 1000
+
+// maximum number of grid_blocks looked at in one prefetch pass
+#define TERRAIN_PREFETCH_MAX_BLOCKS 8
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -236,8 +249,22 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
+        // the last time access was requested to this block
         uint32_t last_access_ms;
+
+        // time the block was queued for a disk read
+        uint32_t read_request_ms;
+
+        // neighbours in the LRU list, most recently used first
+        uint16_t lru_prev;
+        uint16_t lru_next;
+
+        // next block in the same hash bucket
+        uint16_t hash_next;
+
+        // true if the block was loaded by the prefetcher and has not
+        // been used yet
+        bool prefetched;
     };
 
     /*
@@ -277,6 +304,17 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      hash table and LRU list maintenance for the grid cache
+     */
+    uint16_t grid_hash(int32_t lat, int32_t lon, uint16_t spacing) const;
+    int16_t lookup_grid_cache(int32_t lat, int32_t lon, uint16_t spacing) const;
+    void hash_insert(uint16_t idx);
+    void hash_remove(uint16_t idx);
+    void lru_unlink(uint16_t idx);
+    void lru_push_front(uint16_t idx);
+    uint16_t reuse_grid_cache(const struct grid_info &info);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -308,7 +346,7 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
+    int16_t find_io_idx(void);
     uint16_t get_block_crc(struct grid_block &block);
     void check_disk_read(void);
     void check_disk_write(void);
@@ -328,10 +366,24 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      find the next navigation waypoint at or after index
+     */
+    bool next_mission_waypoint(uint16_t &index, AP_Mission::Mission_Command &cmd) const;
+
+    /*
+      queue disk reads for grid_blocks ahead of the vehicle
+     */
+    void update_prefetch(void);
+    bool prefetch_location(const Location &loc);
+    void prefetch_path(const Location &from, const Location &to, float &distance, uint16_t &budget);
+
 
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+    AP_Int16 cache_size_param; // number of grid_blocks to keep in memory
+    AP_Int16 prefetch_time; // seconds of flight to prefetch ahead
 
     // reference to AHRS, so we can ask for our position,
     // heading and speed
@@ -346,9 +398,36 @@ private:
     const AP_Rally &rally;
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // head (most recently used) and tail of the LRU list
+    uint16_t lru_head = TERRAIN_CACHE_NONE;
+    uint16_t lru_tail = TERRAIN_CACHE_NONE;
+
+    // hash buckets of cache indexes, keyed on grid lat/lon/spacing
+    uint16_t *hash_table = nullptr;
+    uint16_t hash_mask;
+
+    // cache index of the block in disk_block
+    uint16_t disk_io_idx = TERRAIN_CACHE_NONE;
+
+    // last time we looked for blocks to prefetch
+    uint32_t last_prefetch_ms;
+
+    // cache statistics, logged as TERC
+    struct {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        uint32_t prefetches;
+        uint32_t prefetch_hits;
+        // disk read latency since the last log message
+        uint32_t read_count;
+        uint32_t read_total_ms;
+        uint32_t read_max_ms;
+    } cache_stats;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -36,17 +36,24 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Blocks that have
+  been asked for are read most recently used first, ahead of any
+  prefetched blocks
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+    for (uint8_t pass=0; pass<2; pass++) {
+        const bool want_prefetched = (pass == 1);
+        for (uint16_t i=lru_head; i != TERRAIN_CACHE_NONE; i=cache[i].lru_next) {
+            if (cache[i].state == GRID_CACHE_DISKWAIT &&
+                cache[i].prefetched == want_prefetched) {
+                disk_block.block = cache[i].grid;
+                disk_io_idx = i;
+                disk_io_state = DiskIoWaitRead;
+                return;
+            }
         }
-    }    
+    }
 }
 
 /*
@@ -57,6 +64,7 @@ void AP_Terrain::check_disk_write(void)
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
             disk_block.block = cache[i].grid;
+            disk_io_idx = i;
             disk_io_state = DiskIoWaitWrite;
             return;
         }
@@ -79,38 +87,43 @@ void AP_Terrain::schedule_disk_io(void)
 
     switch (disk_io_state) {
     case DiskIoIdle:
-        // look for a block that needs reading or writing
-        check_disk_read();
-        if (disk_io_state == DiskIoIdle) {
-            // still idle, check for writes
-            check_disk_write();            
-        }
         break;
         
     case DiskIoDoneRead: {
         // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
+        int16_t cache_idx = find_io_idx();
         if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
-                // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+            struct grid_cache &gcache = cache[cache_idx];
+            if (disk_block.block.bitmap != 0 &&
+                disk_block.block.spacing == gcache.grid.spacing) {
+                // when bitmap is zero we read an empty block. The
+                // block keeps its place in the hash table as its
+                // lat, lon and spacing are unchanged
+                gcache.grid = disk_block.block;
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            gcache.state = GRID_CACHE_VALID;
+            uint32_t now = AP_HAL::millis();
+            uint32_t latency = now - gcache.read_request_ms;
+            cache_stats.read_count++;
+            cache_stats.read_total_ms += latency;
+            cache_stats.read_max_ms = MAX(cache_stats.read_max_ms, latency);
+            gcache.last_access_ms = now;
         }
+        disk_io_idx = TERRAIN_CACHE_NONE;
         disk_io_state = DiskIoIdle;
         break;
     }
 
     case DiskIoDoneWrite: {
         // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
+        int16_t cache_idx = find_io_idx();
         if (cache_idx != -1) {
             if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
                 // only mark valid if more grids haven't been added
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
         }
+        disk_io_idx = TERRAIN_CACHE_NONE;
         disk_io_state = DiskIoIdle;
         break;
     }
@@ -120,6 +133,17 @@ void AP_Terrain::schedule_disk_io(void)
         // waiting for io_timer()
         break;
     }
+
+    if (disk_io_state == DiskIoIdle) {
+        // look for a block that needs reading or writing. This is
+        // done straight after a completed IO so the IO thread is
+        // kept busy while blocks are waiting
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            // still idle, check for writes
+            check_disk_write();            
+        }
+    }
 }
 
 
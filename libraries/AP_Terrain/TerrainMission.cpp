@@ -27,6 +27,27 @@
 
 extern const AP_HAL::HAL& hal;
 
+/*
+  find the next navigation waypoint in the mission at or after
+  index. We only want nav waypoint commands. That should be enough to
+  prefill the terrain data and makes many things much simpler
+ */
+bool AP_Terrain::next_mission_waypoint(uint16_t &index, AP_Mission::Mission_Command &cmd) const
+{
+    if (!mission.read_cmd_from_storage(index, cmd)) {
+        return false;
+    }
+    while ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
+            cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
+           (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+        index++;
+        if (!mission.read_cmd_from_storage(index, cmd)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /*
   check that we have fetched all mission terrain data
  */
@@ -55,28 +76,15 @@ void AP_Terrain::update_mission_data(void)
     // don't do more than 20 waypoints at a time, to prevent too much
     // CPU usage
     for (uint8_t i=0; i<20; i++) {
-        // get next mission command
+        // get next mission waypoint
         AP_Mission::Mission_Command cmd;
-        if (!mission.read_cmd_from_storage(next_mission_index, cmd)) {
+        if (!next_mission_waypoint(next_mission_index, cmd)) {
             // nothing more to do
             next_mission_index = 0;
+            next_mission_pos = 0;
             return;
         }
 
-        // we only want nav waypoint commands. That should be enough to
-        // prefill the terrain data and makes many things much simpler
-        while ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
-                cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
-               (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
-            next_mission_index++;
-            if (!mission.read_cmd_from_storage(next_mission_index, cmd)) {
-                // nothing more to do
-                next_mission_index = 0;
-                next_mission_pos = 0;
-                return;
-            }
-        }
-
         // we will fetch 5 points around the waypoint. Four at 10 grid
         // spacings away at 45, 135, 225 and 315 degrees, and the
         // point itself
@@ -157,4 +165,116 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  queue a disk read of the grid_block holding a location, if it is not
+  already in the cache. Returns true if a read was queued
+ */
+bool AP_Terrain::prefetch_location(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    if (lookup_grid_cache(info.grid_lat, info.grid_lon, grid_spacing) != -1) {
+        return false;
+    }
+    // never push out unsaved data or a block that has been asked for
+    const struct grid_cache &tail = cache[lru_tail];
+    if (tail.state == GRID_CACHE_DIRTY ||
+        (tail.state == GRID_CACHE_DISKWAIT && !tail.prefetched)) {
+        return false;
+    }
+    uint16_t idx = reuse_grid_cache(info);
+    cache[idx].prefetched = true;
+    cache_stats.prefetches++;
+    return true;
+}
+
+/*
+  prefetch grid_blocks along a straight path, using up distance and
+  the budget of blocks to prefetch
+ */
+void AP_Terrain::prefetch_path(const Location &from, const Location &to, float &distance, uint16_t &budget)
+{
+    const float leg = get_distance(from, to);
+    const float bearing = get_bearing_cd(from, to) * 0.01f;
+
+    // step by half the smaller dimension of a grid_block so we can't
+    // skip over one
+    const float step = 0.5f * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+
+    Location loc = from;
+    float travelled = 0;
+    while (travelled < leg && distance > 0 && budget > 0) {
+        float len = MIN(step, MIN(leg - travelled, distance));
+        location_update(loc, bearing, len);
+        travelled += len;
+        distance -= len;
+        if (prefetch_location(loc)) {
+            budget--;
+        }
+    }
+}
+
+/*
+  queue disk reads for the grid_blocks the vehicle will fly over in
+  the next TERRAIN_PREFETCH seconds. In auto this follows the mission
+  legs from the current position, otherwise the current ground track
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (prefetch_time <= 0 || cache == nullptr || grid_spacing <= 0) {
+        return;
+    }
+    uint32_t now = AP_HAL::millis();
+    if (now - last_prefetch_ms < TERRAIN_PREFETCH_INTERVAL_MS) {
+        return;
+    }
+    last_prefetch_ms = now;
+
+    Location loc;
+    if (!ahrs.get_position(loc)) {
+        // we don't know where we are
+        return;
+    }
+    Vector2f velocity = ahrs.groundspeed_vector();
+    float speed = velocity.length();
+    if (speed < 1) {
+        // nothing ahead of us to fetch
+        return;
+    }
+
+    // limit unused prefetched blocks to a third of the cache so they
+    // can't push out the blocks around the vehicle
+    uint16_t unused = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].prefetched) {
+            unused++;
+        }
+    }
+    uint16_t limit = MAX(cache_size / 3, 1);
+    if (unused >= limit) {
+        return;
+    }
+    uint16_t budget = MIN(limit - unused, TERRAIN_PREFETCH_MAX_BLOCKS);
+    float distance = speed * prefetch_time;
+
+    if (mission.state() == AP_Mission::MISSION_RUNNING) {
+        // follow the mission legs, looking at no more than 20
+        // waypoints to bound CPU usage
+        uint16_t index = mission.get_current_nav_index();
+        AP_Mission::Mission_Command cmd;
+        Location from = loc;
+        for (uint8_t i=0;
+             i<20 && index != 0 && distance > 0 && budget > 0 && next_mission_waypoint(index, cmd);
+             i++) {
+            prefetch_path(from, cmd.content.location, distance, budget);
+            from = cmd.content.location;
+            index++;
+        }
+    } else {
+        Location to = loc;
+        location_offset(to, velocity.x * prefetch_time, velocity.y * prefetch_time);
+        prefetch_path(loc, to, distance, budget);
+    }
+}
+
 #endif // AP_TERRAIN_AVAILABLE
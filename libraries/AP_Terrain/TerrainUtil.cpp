@@ -112,30 +112,115 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  hash a grid block identity into a bucket of hash_table
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+uint16_t AP_Terrain::grid_hash(int32_t lat, int32_t lon, uint16_t spacing) const
 {
-    uint16_t oldest_i = 0;
+    uint32_t h = ((uint32_t)lat) * 2654435761U;
+    h ^= ((uint32_t)lon) * 2246822519U;
+    h ^= ((uint32_t)spacing) * 3266489917U;
+    h ^= h >> 16;
+    return h & hash_mask;
+}
 
-    // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == info.grid_lat && 
-            cache[i].grid.lon == info.grid_lon &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+/*
+  find the cache index of a grid block, or -1 if it is not in the cache
+ */
+int16_t AP_Terrain::lookup_grid_cache(int32_t lat, int32_t lon, uint16_t spacing) const
+{
+    for (uint16_t i = hash_table[grid_hash(lat, lon, spacing)];
+         i != TERRAIN_CACHE_NONE;
+         i = cache[i].hash_next) {
+        if (cache[i].grid.lat == lat &&
+            cache[i].grid.lon == lon &&
+            cache[i].grid.spacing == spacing) {
+            return i;
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
+    }
+    return -1;
+}
+
+/*
+  add a cache entry to the hash table using its current identity
+ */
+void AP_Terrain::hash_insert(uint16_t idx)
+{
+    uint16_t &head = hash_table[grid_hash(cache[idx].grid.lat, cache[idx].grid.lon, cache[idx].grid.spacing)];
+    cache[idx].hash_next = head;
+    head = idx;
+}
+
+/*
+  remove a cache entry from the hash table. Entries that were never
+  given an identity are not in the table
+ */
+void AP_Terrain::hash_remove(uint16_t idx)
+{
+    if (cache[idx].state == GRID_CACHE_INVALID) {
+        return;
+    }
+    uint16_t *p = &hash_table[grid_hash(cache[idx].grid.lat, cache[idx].grid.lon, cache[idx].grid.spacing)];
+    while (*p != TERRAIN_CACHE_NONE) {
+        if (*p == idx) {
+            *p = cache[idx].hash_next;
+            break;
         }
+        p = &cache[*p].hash_next;
+    }
+    cache[idx].hash_next = TERRAIN_CACHE_NONE;
+}
+
+/*
+  LRU list maintenance
+ */
+void AP_Terrain::lru_unlink(uint16_t idx)
+{
+    struct grid_cache &c = cache[idx];
+    if (c.lru_prev != TERRAIN_CACHE_NONE) {
+        cache[c.lru_prev].lru_next = c.lru_next;
+    } else {
+        lru_head = c.lru_next;
     }
+    if (c.lru_next != TERRAIN_CACHE_NONE) {
+        cache[c.lru_next].lru_prev = c.lru_prev;
+    } else {
+        lru_tail = c.lru_prev;
+    }
+    c.lru_prev = TERRAIN_CACHE_NONE;
+    c.lru_next = TERRAIN_CACHE_NONE;
+}
+
+void AP_Terrain::lru_push_front(uint16_t idx)
+{
+    struct grid_cache &c = cache[idx];
+    c.lru_prev = TERRAIN_CACHE_NONE;
+    c.lru_next = lru_head;
+    if (lru_head != TERRAIN_CACHE_NONE) {
+        cache[lru_head].lru_prev = idx;
+    }
+    lru_head = idx;
+    if (lru_tail == TERRAIN_CACHE_NONE) {
+        lru_tail = idx;
+    }
+}
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
-    memset(&grid, 0, sizeof(grid));
+/*
+  take the least recently used cache entry and make it the grid given
+  by info, initially unpopulated and waiting for a disk read. The
+  entry is moved to the front of the LRU list
+ */
+uint16_t AP_Terrain::reuse_grid_cache(const struct grid_info &info)
+{
+    uint16_t idx = lru_tail;
+    struct grid_cache &grid = cache[idx];
 
+    if (grid.state != GRID_CACHE_INVALID) {
+        cache_stats.evictions++;
+    }
+    hash_remove(idx);
+    lru_unlink(idx);
+
+    memset(&grid.grid, 0, sizeof(grid.grid));
     grid.grid.lat = info.grid_lat;
     grid.grid.lon = info.grid_lon;
     grid.grid.spacing = grid_spacing;
@@ -145,33 +230,59 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = AP_HAL::millis();
+    grid.read_request_ms = grid.last_access_ms;
+    grid.prefetched = false;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
-    return grid;
+    hash_insert(idx);
+    lru_push_front(idx);
+
+    return idx;
 }
 
 /*
-  find cache index of disk_block
+  find a grid structure given a grid_info
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    // try first with given state
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon && 
-            cache[i].state == state) {
-            return i;
+    // see if we have that grid
+    int16_t i = lookup_grid_cache(info.grid_lat, info.grid_lon, grid_spacing);
+    if (i != -1) {
+        struct grid_cache &grid = cache[i];
+        cache_stats.hits++;
+        if (grid.prefetched) {
+            cache_stats.prefetch_hits++;
+            grid.prefetched = false;
         }
-    }    
-    // then any state
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon) {
-            return i;
+        grid.last_access_ms = AP_HAL::millis();
+        if (lru_head != i) {
+            lru_unlink(i);
+            lru_push_front(i);
         }
-    }    
+        return grid;
+    }
+
+    // Not found. Use the oldest grid and make it this grid
+    cache_stats.misses++;
+    return cache[reuse_grid_cache(info)];
+}
+
+/*
+  find cache index of disk_block. The block may have been evicted
+  while the IO was in progress, in which case -1 is returned
+ */
+int16_t AP_Terrain::find_io_idx(void)
+{
+    if (disk_io_idx == TERRAIN_CACHE_NONE) {
+        return -1;
+    }
+    const struct grid_cache &c = cache[disk_io_idx];
+    if (disk_block.block.lat == c.grid.lat &&
+        disk_block.block.lon == c.grid.lon) {
+        return disk_io_idx;
+    }
     return -1;
 }
 
@@ -39,6 +39,22 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_FILE_DSRMROT",  4, DataFlash_Class, _params.file_disarm_rot,       0),
 
+    // @Param: _FILE_SYNC
+    // @DisplayName: DataFlash File Backend sync interval
+    // @Description: On Linux the DataFlash_File backend writes all buffered data in a single vectored write and only flushes the file to the storage device with fdatasync at this interval. Lower values lose less data on power loss, higher values give the storage device larger writes. Zero syncs after every write. Not used on other boards.
+    // @Units: ms
+    // @Range: 0 5000
+    // @Increment: 100
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_SYNC",  5, DataFlash_Class, _params.file_sync_ms,       500),
+
+    // @Param: _FILE_DIRECT
+    // @DisplayName: DataFlash File Backend direct IO
+    // @Description: On Linux open log files with O_DIRECT so that log data bypasses the page cache. Data is written in aligned blocks. Takes effect when the next log is opened. Not used on other boards, or if the filesystem does not support direct IO.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_DIRECT",  6, DataFlash_Class, _params.file_direct,       0),
+
     AP_GROUPEND
 };
 
@@ -194,6 +194,8 @@ public:
         AP_Int8 file_disarm_rot;
         AP_Int8 log_disarmed;
         AP_Int8 log_replay;
+        AP_Int16 file_sync_ms;
+        AP_Int8 file_direct;
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -30,6 +30,9 @@
 #include <time.h>
 #include <dirent.h>
 #include <GCS_MAVLink/GCS.h>
+#if DATAFLASH_FILE_BATCHED
+#include <sys/uio.h>
+#endif
 #if defined(__APPLE__) && defined(__MACH__)
 #include <sys/param.h>
 #include <sys/mount.h>
@@ -80,7 +83,8 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
     _perf_errors(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_errors")),
-    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns"))
+    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns")),
+    _perf_dropped(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_dropped"))
 {}
 
 
@@ -185,6 +189,8 @@ bool DataFlash_File::log_exists(const uint16_t lognum) const
 
 void DataFlash_File::periodic_1Hz(const uint32_t now)
 {
+    Log_Write_DF_File_Stats(now);
+
     if (!io_thread_alive()) {
         GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "No IO Thread Heartbeat");
         // If you try to close the file here then it will almost
@@ -198,6 +204,53 @@ void DataFlash_File::periodic_1Hz(const uint32_t now)
 void DataFlash_File::periodic_fullrate(const uint32_t now)
 {
     DataFlash_Backend::push_log_blocks();
+    stats_collect();
+}
+
+// sample the write buffer depth, called from the main thread
+void DataFlash_File::stats_collect()
+{
+    const uint32_t queued = _writebuf.available();
+    _stats.queue_sum += queued;
+    _stats.queue_count++;
+    if (queued > _stats.queue_max) {
+        _stats.queue_max = queued;
+    }
+}
+
+void DataFlash_File::Log_Write_DF_File_Stats(const uint32_t now)
+{
+    if (_write_fd == -1 || !log_write_started || _stats.queue_count == 0) {
+        return;
+    }
+
+    // take a copy of the IO thread counters so we log consistent deltas
+    const uint32_t bytes = _stats.bytes;
+    const uint32_t writes = _stats.writes;
+    const uint32_t syncs = _stats.syncs;
+    const uint32_t dt = now - _stats.last_log_time;
+
+    struct log_DF_File_Stats pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_DF_FILE_STATS),
+        timestamp     : now,
+        dropped       : _dropped - _stats.last_dropped,
+        bytes_per_sec : dt ? (uint32_t)(((uint64_t)(bytes - _stats.last_bytes) * 1000) / dt) : 0,
+        queue_avg     : _stats.queue_sum / _stats.queue_count,
+        queue_max     : _stats.queue_max,
+        writes        : (uint16_t)MIN(writes - _stats.last_writes, (uint32_t)UINT16_MAX),
+        syncs         : (uint16_t)MIN(syncs - _stats.last_syncs, (uint32_t)UINT16_MAX),
+    };
+
+    _stats.last_bytes = bytes;
+    _stats.last_writes = writes;
+    _stats.last_syncs = syncs;
+    _stats.last_dropped = _dropped;
+    _stats.last_log_time = now;
+    _stats.queue_sum = 0;
+    _stats.queue_count = 0;
+    _stats.queue_max = 0;
+
+    WriteBlock(&pkt, sizeof(pkt));
 }
 
 uint32_t DataFlash_File::bufferspace_available()
@@ -479,6 +532,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
 
     if (! WriteBlockCheckStartupMessages()) {
         _dropped++;
+        hal.util->perf_count(_perf_dropped);
         return false;
     }
 
@@ -503,6 +557,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
         // we reserve some amount of space for critical messages:
         if (!is_critical && space < critical_message_reserved_space()) {
             _dropped++;
+            hal.util->perf_count(_perf_dropped);
             semaphore->give();
             return false;
         }
@@ -511,6 +566,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
     // if no room for entire message - drop it:
     if (space < size) {
         hal.util->perf_count(_perf_overruns);
+        hal.util->perf_count(_perf_dropped);
         _dropped++;
         semaphore->give();
         return false;
@@ -817,7 +873,31 @@ uint16_t DataFlash_File::start_new_log(void)
     if (fname == nullptr) {
         return 0xFFFF;
     }
-    _write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0666);
+    const int open_flags = O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC;
+#if DATAFLASH_FILE_BATCHED
+    _direct = false;
+    _direct_active = false;
+    _sync_pending = false;
+    if (_front._params.file_direct != 0) {
+        if (_direct_buf == nullptr &&
+            posix_memalign((void **)&_direct_buf, DATAFLASH_FILE_DIRECT_ALIGN, _writebuf.get_size()) != 0) {
+            _direct_buf = nullptr;
+        }
+        if (_direct_buf != nullptr) {
+            // not all filesystems support O_DIRECT; fall back to
+            // buffered writes if the open fails
+            _direct = true;
+            _direct_active = true;
+            _write_fd = ::open(fname, open_flags|O_DIRECT, 0666);
+            if (_write_fd == -1) {
+                _direct = false;
+                _direct_active = false;
+            }
+        }
+    }
+    if (_write_fd == -1)
+#endif
+    _write_fd = ::open(fname, open_flags, 0666);
     _cached_oldest_log = 0;
 
     if (_write_fd == -1) {
@@ -1036,6 +1116,11 @@ void DataFlash_File::_io_timer(void)
         return;
     }
 
+#if DATAFLASH_FILE_BATCHED
+    // make sure the last write reaches the card even if no more data arrives
+    _sync_if_due(tnow);
+#endif
+
     uint32_t nbytes = _writebuf.available();
     if (nbytes == 0) {
         return;
@@ -1059,6 +1144,9 @@ void DataFlash_File::_io_timer(void)
     hal.util->perf_begin(_perf_write);
 
     _last_write_time = tnow;
+#if DATAFLASH_FILE_BATCHED
+    ssize_t nwritten = _write_batch(nbytes);
+#else
     if (nbytes > _writebuf_chunk) {
         // be kind to the FAT PX4 filesystem
         nbytes = _writebuf_chunk;
@@ -1077,6 +1165,7 @@ void DataFlash_File::_io_timer(void)
     }
 
     ssize_t nwritten = ::write(_write_fd, head, nbytes);
+#endif
     if (nwritten <= 0) {
         hal.util->perf_count(_perf_errors);
         close(_write_fd);
@@ -1085,6 +1174,12 @@ void DataFlash_File::_io_timer(void)
     } else {
         _write_offset += nwritten;
         _writebuf.advance(nwritten);
+        _stats.bytes += nwritten;
+        _stats.writes++;
+#if DATAFLASH_FILE_BATCHED
+        _sync_pending = true;
+        _sync_if_due(tnow);
+#else
         /*
           the best strategy for minimizing corruption on microSD cards
           seems to be to write in 4k chunks and fsync the file on each
@@ -1093,11 +1188,121 @@ void DataFlash_File::_io_timer(void)
          */
 #if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
         ::fsync(_write_fd);
+        _stats.syncs++;
+#endif
 #endif
     }
     hal.util->perf_end(_perf_write);
 }
 
+#if DATAFLASH_FILE_BATCHED
+/*
+  write a contiguous or wrapped range of the ring buffer without copying
+ */
+static ssize_t write_ring(int fd, ByteBuffer &buf, uint32_t nbytes)
+{
+    ByteBuffer::IoVec vec[2];
+    struct iovec iov[2];
+
+    const uint8_t n_vec = buf.peekiovec(vec, nbytes);
+    for (uint8_t i=0; i<n_vec; i++) {
+        iov[i].iov_base = vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+    return ::writev(fd, iov, n_vec);
+}
+
+/*
+  write everything that is buffered with a single system call. Called
+  from the IO thread only
+ */
+ssize_t DataFlash_File::_write_batch(uint32_t nbytes)
+{
+    if (_direct) {
+        return _write_direct(nbytes);
+    }
+
+    // try to end writes on a 512 byte boundary to avoid filesystem reads
+    if ((nbytes + _write_offset) % 512 != 0) {
+        uint32_t ofs = (nbytes + _write_offset) % 512;
+        if (ofs < nbytes) {
+            nbytes -= ofs;
+        }
+    }
+
+    return write_ring(_write_fd, _writebuf, nbytes);
+}
+
+/*
+  O_DIRECT needs the file offset, length and memory of each write to be
+  aligned, so whole blocks are copied into an aligned buffer. A partial
+  block is only written on flush or on the write timeout; that is done
+  with O_DIRECT cleared, and the following write brings the file offset
+  back into alignment before O_DIRECT is set again
+ */
+ssize_t DataFlash_File::_write_direct(uint32_t nbytes)
+{
+    const uint32_t misalign = _write_offset % DATAFLASH_FILE_DIRECT_ALIGN;
+    if (misalign != 0 || nbytes < DATAFLASH_FILE_DIRECT_ALIGN) {
+        if (!_set_direct(false)) {
+            return -1;
+        }
+        if (misalign != 0) {
+            nbytes = MIN(nbytes, DATAFLASH_FILE_DIRECT_ALIGN - misalign);
+        }
+        return write_ring(_write_fd, _writebuf, nbytes);
+    }
+
+    nbytes -= nbytes % DATAFLASH_FILE_DIRECT_ALIGN;
+    if (!_set_direct(true)) {
+        return -1;
+    }
+    _writebuf.peekbytes(_direct_buf, nbytes);
+    return ::write(_write_fd, _direct_buf, nbytes);
+}
+
+bool DataFlash_File::_set_direct(bool enable)
+{
+    if (enable == _direct_active) {
+        return true;
+    }
+    int flags = fcntl(_write_fd, F_GETFL);
+    if (flags == -1) {
+        return false;
+    }
+    if (enable) {
+        flags |= O_DIRECT;
+    } else {
+        flags &= ~O_DIRECT;
+    }
+    if (fcntl(_write_fd, F_SETFL, flags) == -1) {
+        return false;
+    }
+    _direct_active = enable;
+    return true;
+}
+
+/*
+  flush written data to the storage device if it has been
+  _FILE_SYNC milliseconds since the last sync
+ */
+void DataFlash_File::_sync_if_due(const uint32_t now)
+{
+    if (!_sync_pending ||
+        now - _last_sync_time < (uint32_t)_front._params.file_sync_ms.get()) {
+        return;
+    }
+#if CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE
+    hal.util->perf_begin(_perf_fsync);
+    ::fdatasync(_write_fd);
+    hal.util->perf_end(_perf_fsync);
+    _stats.syncs++;
+#endif
+    _sync_pending = false;
+    _last_sync_time = now;
+}
+#endif // DATAFLASH_FILE_BATCHED
+
 // this sensor is enabled if we should be logging at the moment
 bool DataFlash_File::logging_enabled() const
 {
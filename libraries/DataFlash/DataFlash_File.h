@@ -23,6 +23,20 @@
 #define DATAFLASH_FILE_MINIMAL 0
 #endif
 
+/*
+  on Linux the IO thread drains the whole write buffer with one
+  vectored write, syncs the file at an interval rather than on every
+  write and can optionally bypass the page cache with O_DIRECT
+ */
+#ifndef DATAFLASH_FILE_BATCHED
+#define DATAFLASH_FILE_BATCHED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// alignment of file offsets, lengths and memory for O_DIRECT writes
+#ifndef DATAFLASH_FILE_DIRECT_ALIGN
+#define DATAFLASH_FILE_DIRECT_ALIGN 4096
+#endif
+
 class DataFlash_File : public DataFlash_Backend
 {
 public:
@@ -126,6 +140,40 @@ private:
 
     void _io_timer(void);
 
+#if DATAFLASH_FILE_BATCHED
+    // write up to nbytes from the write buffer, returns bytes written or -1 on error
+    ssize_t _write_batch(uint32_t nbytes);
+    ssize_t _write_direct(uint32_t nbytes);
+    bool _set_direct(bool enable);
+    void _sync_if_due(const uint32_t now);
+
+    uint8_t *_direct_buf;           // aligned bounce buffer for O_DIRECT writes
+    bool _direct;                   // log file was opened with O_DIRECT
+    bool _direct_active;            // O_DIRECT is currently set on _write_fd
+    uint32_t _last_sync_time;
+    bool _sync_pending;
+#endif
+
+    // write statistics, logged as DSF messages. The IO thread only
+    // increments the cumulative counters, the main thread keeps the
+    // rest so neither needs to take the semaphore
+    struct {
+        uint32_t bytes;             // IO thread: total bytes written
+        uint32_t writes;            // IO thread: total write calls
+        uint32_t syncs;             // IO thread: total sync calls
+        uint32_t last_bytes;
+        uint32_t last_writes;
+        uint32_t last_syncs;
+        uint32_t last_dropped;
+        uint32_t last_log_time;
+        uint32_t queue_sum;
+        uint32_t queue_count;
+        uint32_t queue_max;
+    } _stats;
+
+    void stats_collect();
+    void Log_Write_DF_File_Stats(const uint32_t now);
+
     uint32_t critical_message_reserved_space() const {
         // possibly make this a proportional to buffer size?
         uint32_t ret = 1024;
@@ -161,6 +209,7 @@ private:
     AP_HAL::Util::perf_counter_t  _perf_fsync;
     AP_HAL::Util::perf_counter_t  _perf_errors;
     AP_HAL::Util::perf_counter_t  _perf_overruns;
+    AP_HAL::Util::perf_counter_t  _perf_dropped;
 };
 
 #endif // HAL_OS_POSIX_IO
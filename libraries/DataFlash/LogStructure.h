@@ -527,6 +527,19 @@ struct PACKED log_TERRAIN {
     uint16_t loaded;
 };
 
+struct PACKED log_TERRAIN_CACHE {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t prefetches;
+    uint32_t prefetch_hits;     // prefetched blocks later used
+    uint16_t read_avg_ms;       // disk read latency since the last message
+    uint16_t read_max_ms;
+    uint16_t cache_size;
+};
+
 /*
   UBlox logging
  */
@@ -665,6 +678,17 @@ struct PACKED log_DF_MAV_Stats {
     // uint8_t state_retry_max;
 };
 
+struct PACKED log_DF_File_Stats {
+    LOG_PACKET_HEADER;
+    uint32_t timestamp;
+    uint32_t dropped;
+    uint32_t bytes_per_sec;
+    uint32_t queue_avg;     // bytes waiting in the write buffer
+    uint32_t queue_max;
+    uint16_t writes;        // write calls since the last message
+    uint16_t syncs;         // fsync/fdatasync calls since the last message
+};
+
 struct PACKED log_ORGN {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -821,7 +845,9 @@ Format characters in the format string for binary log messages
     { LOG_RFND_MSG, sizeof(log_RFND), \
       "RFND", "QCC",         "TimeUS,Dist1,Dist2" }, \
     { LOG_DF_MAV_STATS, sizeof(log_DF_MAV_Stats), \
-      "DMS", "IIIIIBBBBBBBBBB",         "TimeMS,N,Dp,RT,RS,Er,Fa,Fmn,Fmx,Pa,Pmn,Pmx,Sa,Smn,Smx" }
+      "DMS", "IIIIIBBBBBBBBBB",         "TimeMS,N,Dp,RT,RS,Er,Fa,Fmn,Fmx,Pa,Pmn,Pmx,Sa,Smn,Smx" }, \
+    { LOG_DF_FILE_STATS, sizeof(log_DF_File_Stats), \
+      "DSF", "IIIIIHH",         "TimeMS,Dp,Bps,Qavg,Qmax,Wr,Sy" }
 
 // messages for more advanced boards
 #define LOG_EXTRA_STRUCTURES \
@@ -877,6 +903,8 @@ Format characters in the format string for binary log messages
       "XKF0","QBccCCccccc","TimeUS,ID,rng,innov,SIV,TR,BPN,BPE,BPD,OFH,OFL" }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
       "TERR","QBLLHffHH","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded" }, \
+    { LOG_TERRAIN_CACHE_MSG, sizeof(log_TERRAIN_CACHE), \
+      "TERC","QIIIIIHHH","TimeUS,Hit,Miss,Evict,Pf,PfHit,RdAvg,RdMax,Size" }, \
     { LOG_GPS_UBX1_MSG, sizeof(log_Ubx1), \
       "UBX1", "QBHBBH",  "TimeUS,Instance,noisePerMS,jamInd,aPower,agcCnt" }, \
     { LOG_GPS_UBX2_MSG, sizeof(log_Ubx2), \
@@ -1082,6 +1110,8 @@ enum LogMessages {
     LOG_GIMBAL3_MSG,
     LOG_RATE_MSG,
     LOG_RALLY_MSG,
+    LOG_DF_FILE_STATS,
+    LOG_TERRAIN_CACHE_MSG,
 };
 
 enum LogOriginType {
@@ -109,6 +109,7 @@ public:
         mavlink_statustext_t    msg;
     };
     static ObjectArray<statustext_t> _statustext_queue;
+    static AP_HAL::Semaphore *_statustext_sem;
 
 
     // accessor for uart
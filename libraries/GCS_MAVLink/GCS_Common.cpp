@@ -35,6 +35,7 @@ uint32_t GCS_MAVLINK::last_radio_status_remrssi_ms;
 uint8_t GCS_MAVLINK::mavlink_active = 0;
 uint8_t GCS_MAVLINK::chan_is_streaming = 0;
 ObjectArray<GCS_MAVLINK::statustext_t> GCS_MAVLINK::_statustext_queue(GCS_MAVLINK_PAYLOAD_STATUS_CAPACITY);
+AP_HAL::Semaphore *GCS_MAVLINK::_statustext_sem;
 uint32_t GCS_MAVLINK::reserve_param_space_start_ms;
 
 GCS_MAVLINK::GCS_MAVLINK()
@@ -52,6 +53,10 @@ GCS_MAVLINK::init(AP_HAL::UARTDriver *port, mavlink_channel_t mav_chan)
     _port = port;
     chan = mav_chan;
 
+    if (_statustext_sem == nullptr) {
+        _statustext_sem = hal.util->new_semaphore();
+    }
+
     mavlink_comm_port[chan] = _port;
     initialised = true;
     _queued_parameter = nullptr;
@@ -1348,6 +1353,12 @@ void GCS_MAVLINK::send_statustext_chan(MAV_SEVERITY severity, uint8_t dest_chan,
 */
 void GCS_MAVLINK::send_statustext(MAV_SEVERITY severity, uint8_t dest_bitmask, const char *text)
 {
+    // EKF cores may send text from worker threads on Linux, so
+    // serialise access to the queue and the FrSky library
+    if (_statustext_sem != nullptr && !_statustext_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+
     if (dataflash_p != nullptr) {
         dataflash_p->Log_Write_Message(text);
     }
@@ -1360,21 +1371,22 @@ void GCS_MAVLINK::send_statustext(MAV_SEVERITY severity, uint8_t dest_bitmask, c
     // filter destination ports to only allow active ports.
     statustext_t statustext{};
     statustext.bitmask = (mavlink_active | chan_is_streaming) & dest_bitmask;
-    if (!statustext.bitmask) {
-        // nowhere to send
-        return;
-    }
+    if (statustext.bitmask) {
+        statustext.msg.severity = severity;
+        strncpy(statustext.msg.text, text, sizeof(statustext.msg.text));
 
-    statustext.msg.severity = severity;
-    strncpy(statustext.msg.text, text, sizeof(statustext.msg.text));
+        // The force push will ensure comm links do not block other comm links forever if they fail.
+        // If we push to a full buffer then we overwrite the oldest entry, effectively removing the
+        // block but not until the buffer fills up.
+        _statustext_queue.push_force(statustext);
 
-    // The force push will ensure comm links do not block other comm links forever if they fail.
-    // If we push to a full buffer then we overwrite the oldest entry, effectively removing the
-    // block but not until the buffer fills up.
-    _statustext_queue.push_force(statustext);
+        // try and send immediately if possible
+        service_statustext();
+    }
 
-    // try and send immediately if possible
-    service_statustext();
+    if (_statustext_sem != nullptr) {
+        _statustext_sem->give();
+    }
 }
 /*
     send a statustext message to specific MAVLink connections in a bitmask
@@ -1799,6 +1811,9 @@ uint8_t GCS_MAVLINK::handle_preflight_reboot(const mavlink_command_long_t &packe
 #endif
         }
 
+        // write out any queued parameter saves
+        AP_Param::flush();
+
         // force safety on 
         hal.rcout->force_safety_on();
         hal.rcout->force_safety_no_wait();